@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+using namespace std;
+
+/**
+ * Stateless allocator whose blocks start on an `Align`-byte boundary (64 by
+ * default: one cache line on current x86 and ARM cores), or on `alignof(T)`
+ * if that is larger. With an element size that divides `Align`, such as a
+ * 32- or 64-byte record, no element of an array from this allocator
+ * straddles a cache line.
+ */
+template <typename T, size_t Align = 64>
+class AlignedAllocator {
+  static_assert((Align & (Align - 1)) == 0, "Align must be a power of two");
+
+ public:
+  using value_type = T;
+  using is_always_equal = true_type;
+
+  static constexpr size_t alignment = max(Align, alignof(T));
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Align> &) {
+  }
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), align_val_t(alignment)));
+  }
+
+  void deallocate(T *p, size_t) {
+    ::operator delete(p, align_val_t(alignment));
+  }
+
+  template <typename U>
+  friend bool operator==(const AlignedAllocator &,
+                         const AlignedAllocator<U, Align> &) {
+    return true;
+  }
+};
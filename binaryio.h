@@ -0,0 +1,438 @@
+#pragma once
+
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "circvector.h"
+#include "linkedlist.h"
+
+using namespace std;
+
+/**
+ * Compact binary format for `CircVector` and `LinkedList`, read and written
+ * through POSIX file descriptors.
+ *
+ * A file is a 24-byte `BinaryHeader` followed by the elements in logical
+ * order. Trivially copyable `T` is stored as its raw bytes (`elem_size` is
+ * `sizeof(T)`), so the format is native-endian and tied to the layout of
+ * `T`. Any other `T` needs a `BinaryCodec<T>` specialization, and is stored
+ * in whatever encoding that codec chooses (`elem_size` is 0). Both
+ * containers share the format, so a saved `CircVector` can be loaded as a
+ * `LinkedList` and vice versa.
+ *
+ * Raw elements are never copied through a buffer: a `CircVector` is written
+ * with a single `writev` of the header and its two ring segments, and loaded
+ * with one allocation, reading straight into its buffer. A `LinkedList` is
+ * written with `writev` calls gathering up to `IOV_MAX` nodes each.
+ */
+
+struct BinaryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t elem_size;
+  uint32_t reserved;
+  uint64_t count;
+};
+
+inline constexpr char binary_magic[4] = {'C', 'V', 'L', 'L'};
+inline constexpr uint32_t binary_version = 1;
+
+/**
+ * Buffered output for `BinaryCodec`s.
+ */
+class BinaryWriter {
+ private:
+  int fd;
+  vector<char> buffer;
+
+ public:
+  explicit BinaryWriter(int fd) : fd(fd) {
+    buffer.reserve(1 << 16);
+  }
+
+  /**
+   * Appends `n` bytes from `src`.
+   */
+  void write_bytes(const void *src, size_t n);
+
+  /**
+   * Writes out everything appended so far.
+   */
+  void flush();
+};
+
+/**
+ * Buffered input for `BinaryCodec`s.
+ */
+class BinaryReader {
+ private:
+  int fd;
+  vector<char> buffer;
+  size_t pos = 0;
+
+ public:
+  explicit BinaryReader(int fd) : fd(fd) {
+  }
+
+  /**
+   * Reads exactly `n` bytes into `dest`. Throws `runtime_error` if the file
+   * ends first.
+   */
+  void read_bytes(void *dest, size_t n);
+};
+
+/**
+ * Encoding hook for element types that are not trivially copyable.
+ * Specializations provide
+ *
+ *   static void write(BinaryWriter &out, const T &value);
+ *   static T read(BinaryReader &in);
+ *
+ * and may declare `static constexpr size_t min_bytes`, the fewest bytes an
+ * encoded element takes (1 if absent), which bounds the header count.
+ *
+ * `string` is provided: a 64-bit length followed by the characters.
+ */
+template <typename T>
+struct BinaryCodec;
+
+template <>
+struct BinaryCodec<string> {
+  static constexpr size_t min_bytes = sizeof(uint64_t);
+
+  static void write(BinaryWriter &out, const string &value) {
+    uint64_t length = value.size();
+    out.write_bytes(&length, sizeof(length));
+    out.write_bytes(value.data(), value.size());
+  }
+
+  static string read(BinaryReader &in) {
+    uint64_t length;
+    in.read_bytes(&length, sizeof(length));
+    // Grow a chunk at a time, so that a corrupt length fails with "ends
+    // early" once the data runs out instead of allocating it all up front.
+    const size_t chunk = 1 << 16;
+    string value;
+    while (value.size() < length) {
+      size_t done = value.size();
+      size_t n = min<uint64_t>(length - done, chunk);
+      value.resize(done + n);
+      in.read_bytes(value.data() + done, n);
+    }
+    return value;
+  }
+};
+
+template <typename T>
+concept binary_raw = is_trivially_copyable_v<T>;
+
+template <typename T>
+concept binary_codec = requires(BinaryWriter &out, BinaryReader &in,
+                                const T &value) {
+  BinaryCodec<T>::write(out, value);
+  { BinaryCodec<T>::read(in) } -> same_as<T>;
+};
+
+template <typename T>
+concept binary_serializable = binary_raw<T> || binary_codec<T>;
+
+/**
+ * Returns the fewest bytes one encoded `T` can take in a file.
+ */
+template <binary_serializable T>
+constexpr size_t binary_min_bytes() {
+  if constexpr (binary_raw<T>) {
+    return sizeof(T);
+  }
+  else if constexpr (requires { BinaryCodec<T>::min_bytes; }) {
+    return BinaryCodec<T>::min_bytes;
+  }
+  else {
+    return 1;
+  }
+}
+
+/**
+ * Writes the whole of `iov[0..count)`, resuming after partial writes.
+ * Throws `system_error` on failure.
+ */
+inline void binary_writev(int fd, iovec *iov, size_t count) {
+  while (count > 0) {
+    int batch = static_cast<int>(min<size_t>(count, IOV_MAX));
+    ssize_t written = ::writev(fd, iov, batch);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw system_error(errno, generic_category(), "writev");
+    }
+    size_t left = written;
+    while (count > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+}
+
+/**
+ * Reads exactly `n` bytes into `dest`. Throws `system_error` on failure and
+ * `runtime_error` if the file ends first.
+ */
+inline void binary_read(int fd, void *dest, size_t n) {
+  char *p = static_cast<char *>(dest);
+  while (n > 0) {
+    ssize_t got = ::read(fd, p, n);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw system_error(errno, generic_category(), "read");
+    }
+    if (got == 0) {
+      throw runtime_error("Binary data ends early");
+    }
+    p += got;
+    n -= got;
+  }
+}
+
+inline void BinaryWriter::write_bytes(const void *src, size_t n) {
+  if (buffer.size() + n > buffer.capacity()) {
+    flush();
+  }
+  if (n >= buffer.capacity()) {
+    iovec iov{const_cast<void *>(src), n};
+    binary_writev(fd, &iov, 1);
+    return;
+  }
+  const char *bytes = static_cast<const char *>(src);
+  buffer.insert(buffer.end(), bytes, bytes + n);
+}
+
+inline void BinaryWriter::flush() {
+  if (!buffer.empty()) {
+    iovec iov{buffer.data(), buffer.size()};
+    binary_writev(fd, &iov, 1);
+    buffer.clear();
+  }
+}
+
+inline void BinaryReader::read_bytes(void *dest, size_t n) {
+  char *out = static_cast<char *>(dest);
+  while (n > 0) {
+    if (pos == buffer.size()) {
+      buffer.resize(1 << 16);
+      ssize_t got;
+      do {
+        got = ::read(fd, buffer.data(), buffer.size());
+      } while (got < 0 && errno == EINTR);
+      if (got < 0) {
+        throw system_error(errno, generic_category(), "read");
+      }
+      if (got == 0) {
+        throw runtime_error("Binary data ends early");
+      }
+      buffer.resize(got);
+      pos = 0;
+    }
+    size_t take = min(n, buffer.size() - pos);
+    memcpy(out, buffer.data() + pos, take);
+    out += take;
+    pos += take;
+    n -= take;
+  }
+}
+
+template <typename T>
+BinaryHeader make_binary_header(size_t count) {
+  BinaryHeader header{};
+  memcpy(header.magic, binary_magic, sizeof(header.magic));
+  header.version = binary_version;
+  header.elem_size = binary_raw<T> ? sizeof(T) : 0;
+  header.count = count;
+  return header;
+}
+
+/**
+ * Reads the header and checks that it describes elements of type `T`.
+ * Returns the element count.
+ */
+template <typename T>
+size_t read_binary_header(int fd) {
+  BinaryHeader header;
+  binary_read(fd, &header, sizeof(header));
+  if (memcmp(header.magic, binary_magic, sizeof(header.magic)) != 0 ||
+      header.version != binary_version) {
+    throw runtime_error("Not a binary container file");
+  }
+  if (header.elem_size != make_binary_header<T>(0).elem_size) {
+    throw runtime_error("Binary file holds a different element type");
+  }
+  return header.count;
+}
+
+/**
+ * Checks a header's element count against what is left of the file, before
+ * anything is allocated for it: `count` elements of at least `elem_bytes`
+ * bytes each must fit in the bytes after the current position. Throws
+ * `runtime_error` if they cannot. For pipes and other descriptors without a
+ * known size, only the multiplication is checked, and a short read still
+ * fails later with "Binary data ends early".
+ */
+inline void check_binary_count(int fd, size_t count, size_t elem_bytes) {
+  if (count > numeric_limits<size_t>::max() / elem_bytes) {
+    throw runtime_error("Binary header count is too large");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    throw system_error(errno, generic_category(), "fstat");
+  }
+  if (!S_ISREG(st.st_mode)) {
+    return;
+  }
+  off_t pos = lseek(fd, 0, SEEK_CUR);
+  if (pos < 0) {
+    throw system_error(errno, generic_category(), "lseek");
+  }
+  size_t left = (st.st_size > pos) ? size_t(st.st_size - pos) : 0;
+  if (count * elem_bytes > left) {
+    throw runtime_error("Binary header count exceeds the file size");
+  }
+}
+
+/**
+ * Writes `c` to `fd`. For trivially copyable `T` this is one `writev` of the
+ * header and the two ring segments.
+ */
+template <binary_serializable T, bool P, typename A, size_t N>
+void write_binary(int fd, const CircVector<T, P, A, N> &c) {
+  BinaryHeader header = make_binary_header<T>(c.size());
+  auto [first, second] = c.as_spans();
+  if constexpr (binary_raw<T>) {
+    iovec iov[3] = {
+        {&header, sizeof(header)},
+        {const_cast<T *>(first.data()), first.size_bytes()},
+        {const_cast<T *>(second.data()), second.size_bytes()},
+    };
+    binary_writev(fd, iov, 3);
+  }
+  else {
+    BinaryWriter out(fd);
+    out.write_bytes(&header, sizeof(header));
+    for (const T &elem : c) {
+      BinaryCodec<T>::write(out, elem);
+    }
+    out.flush();
+  }
+}
+
+/**
+ * Writes `list` to `fd`. Trivially copyable elements are gathered straight
+ * from the nodes, up to `IOV_MAX` per `writev`.
+ */
+template <binary_serializable T, typename Alloc, bool Doubly>
+void write_binary(int fd, const LinkedList<T, Alloc, Doubly> &list) {
+  BinaryHeader header = make_binary_header<T>(list.size());
+  if constexpr (binary_raw<T>) {
+    iovec iov[IOV_MAX];
+    iov[0] = {&header, sizeof(header)};
+    size_t used = 1;
+    for (const T &elem : list) {
+      iov[used++] = {const_cast<T *>(&elem), sizeof(T)};
+      if (used == IOV_MAX) {
+        binary_writev(fd, iov, used);
+        used = 0;
+      }
+    }
+    binary_writev(fd, iov, used);
+  }
+  else {
+    BinaryWriter out(fd);
+    out.write_bytes(&header, sizeof(header));
+    for (const T &elem : list) {
+      BinaryCodec<T>::write(out, elem);
+    }
+    out.flush();
+  }
+}
+
+/**
+ * Reads a `CircVector` or `LinkedList` written by `write_binary`, e.g.
+ * `read_binary<CircVector<int>>(fd)`. A `CircVector` of trivially copyable
+ * `T` is allocated once, at the stored size, and read directly into its
+ * buffer.
+ *
+ * Elements read through a `BinaryCodec` are buffered, so in that case the
+ * file offset may end up past the end of the container.
+ *
+ * Throws `runtime_error` if the data is not a container of this element
+ * type, ends early, or has a header count larger than the rest of the file
+ * could hold (checked before allocating), and `system_error` if reading
+ * fails.
+ */
+template <typename C>
+C read_binary(int fd) {
+  using T = remove_cvref_t<decltype(*declval<C &>().begin())>;
+  static_assert(binary_serializable<T>,
+                "element type needs to be trivially copyable or have a "
+                "BinaryCodec");
+  size_t count = read_binary_header<T>(fd);
+  check_binary_count(fd, count, binary_min_bytes<T>());
+
+  if constexpr (binary_raw<T> && requires(C c) {
+                  c.append_uninitialized(0, [](T *, size_t) {});
+                }) {
+    C c(max<size_t>(count, 1));
+    c.append_uninitialized(count, [&](T *dest, size_t n) {
+      binary_read(fd, dest, n * sizeof(T));
+    });
+    return c;
+  }
+  else if constexpr (binary_raw<T>) {
+    // Read a block at a time into raw storage, so `T` need not be
+    // default-constructible.
+    const size_t block = 4096 / sizeof(T) + 1;
+    alignas(T) unsigned char storage[block * sizeof(T)];
+    C c;
+    while (count > 0) {
+      size_t n = min(count, block);
+      binary_read(fd, storage, n * sizeof(T));
+      for (size_t i = 0; i < n; i++) {
+        c.push_back(*launder(reinterpret_cast<T *>(storage + i * sizeof(T))));
+      }
+      count -= n;
+    }
+    return c;
+  }
+  else {
+    C c;
+    if constexpr (requires { c.reserve(count); }) {
+      c.reserve(count);
+    }
+    BinaryReader in(fd);
+    for (size_t i = 0; i < count; i++) {
+      c.push_back(BinaryCodec<T>::read(in));
+    }
+    return c;
+  }
+}
@@ -0,0 +1,179 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "binaryio.h"
+
+using namespace std;
+using namespace testing;
+
+namespace {
+
+struct Point {
+  int32_t x;
+  int32_t y;
+
+  Point(int32_t x, int32_t y) : x(x), y(y) {
+  }
+};
+
+// An unlinked temporary file, rewound with `rewind()` between writing and
+// reading.
+struct TempFile {
+  int fd;
+
+  TempFile() {
+    string path = TempDir() + "binaryio_XXXXXX";
+    fd = mkstemp(path.data());
+    unlink(path.c_str());
+  }
+
+  ~TempFile() {
+    close(fd);
+  }
+
+  void rewind() {
+    lseek(fd, 0, SEEK_SET);
+  }
+
+  off_t size() {
+    return lseek(fd, 0, SEEK_END);
+  }
+};
+
+}  // namespace
+
+TEST(BinaryIO, circVectorRoundTrip) {
+  CircVector<int64_t> v(8);
+  for (int i = 0; i < 5; i++) {
+    v.push_back(i);
+  }
+  for (int i = 1; i <= 3; i++) {
+    v.push_front(-i);
+  }
+  ASSERT_THAT(v.as_spans().second.empty(), Eq(false));
+
+  TempFile file;
+  write_binary(file.fd, v);
+  EXPECT_THAT(file.size(), Eq(sizeof(BinaryHeader) + 8 * sizeof(int64_t)));
+  file.rewind();
+  CircVector<int64_t> loaded = read_binary<CircVector<int64_t>>(file.fd);
+  EXPECT_THAT(loaded.to_string(), Eq(v.to_string()));
+  EXPECT_THAT(loaded.get_capacity(), Eq(8));
+
+  // Non-default-constructible records, and loading into the other container.
+  CircVector<Point, false> points(3);
+  points.push_back(Point(1, 2));
+  points.push_front(Point(3, 4));
+  TempFile point_file;
+  write_binary(point_file.fd, points);
+  point_file.rewind();
+  auto list = read_binary<LinkedList<Point>>(point_file.fd);
+  EXPECT_THAT(list.size(), Eq(2));
+  EXPECT_THAT(list.at(0).x, Eq(3));
+  EXPECT_THAT(list.at(1).y, Eq(2));
+
+  TempFile empty_file;
+  write_binary(empty_file.fd, CircVector<int>());
+  empty_file.rewind();
+  EXPECT_THAT(read_binary<CircVector<int>>(empty_file.fd).empty(), Eq(true));
+}
+TEST(BinaryIO, linkedListRoundTrip) {
+  // More nodes than one writev can gather.
+  LinkedList<int> list;
+  for (int i = 0; i < 5000; i++) {
+    list.push_back(i * 3);
+  }
+  TempFile file;
+  write_binary(file.fd, list);
+  file.rewind();
+  LinkedList<int> loaded = read_binary<LinkedList<int>>(file.fd);
+  EXPECT_THAT(loaded.size(), Eq(5000));
+  EXPECT_THAT(loaded.at(0), Eq(0));
+  EXPECT_THAT(loaded.at(4999), Eq(14997));
+  file.rewind();
+  CircVector<int> as_vector = read_binary<CircVector<int>>(file.fd);
+  EXPECT_THAT(as_vector.at(1234), Eq(3702));
+
+  DList<string> words;
+  words.push_back("alpha");
+  words.push_back("");
+  words.push_back(string(100000, 'z'));
+  TempFile word_file;
+  write_binary(word_file.fd, words);
+  word_file.rewind();
+  auto loaded_words = read_binary<CircVector<string>>(word_file.fd);
+  EXPECT_THAT(loaded_words.size(), Eq(3));
+  EXPECT_THAT(loaded_words.at(0), Eq("alpha"));
+  EXPECT_THAT(loaded_words.at(1), Eq(""));
+  EXPECT_THAT(loaded_words.at(2).size(), Eq(100000));
+}
+TEST(BinaryIO, rejectsBadInput) {
+  CircVector<int32_t> v;
+  v.push_back(1);
+  v.push_back(2);
+  TempFile file;
+  write_binary(file.fd, v);
+
+  file.rewind();
+  EXPECT_THROW(read_binary<CircVector<int64_t>>(file.fd), runtime_error);
+  file.rewind();
+  EXPECT_THROW(read_binary<CircVector<string>>(file.fd), runtime_error);
+
+  ftruncate(file.fd, sizeof(BinaryHeader) + 6);
+  file.rewind();
+  EXPECT_THROW(read_binary<CircVector<int32_t>>(file.fd), runtime_error);
+
+  TempFile junk;
+  write(junk.fd, "not a container file at all", 27);
+  junk.rewind();
+  EXPECT_THROW(read_binary<LinkedList<int32_t>>(junk.fd), runtime_error);
+}
+TEST(BinaryIO, rejectsOversizedCounts) {
+  auto write_header = [](TempFile &file, auto elem, uint64_t count) {
+    BinaryHeader header = make_binary_header<decltype(elem)>(count);
+    write(file.fd, &header, sizeof(header));
+    write(file.fd, "0123456789abcdef", 16);
+    file.rewind();
+  };
+
+  // `count * sizeof(T)` wraps around to a small number.
+  TempFile wrapped;
+  write_header(wrapped, int32_t(), 0xC000000000000064);
+  EXPECT_THROW(read_binary<CircVector<int32_t>>(wrapped.fd), runtime_error);
+  wrapped.rewind();
+  EXPECT_THROW(read_binary<LinkedList<int32_t>>(wrapped.fd), runtime_error);
+
+  // More elements than the rest of the file holds.
+  TempFile longer;
+  write_header(longer, int64_t(), 3);
+  EXPECT_THROW(read_binary<CircVector<int64_t>>(longer.fd), runtime_error);
+  TempFile exact;
+  write_header(exact, int64_t(), 2);
+  EXPECT_THAT(read_binary<CircVector<int64_t>>(exact.fd).size(), Eq(2));
+
+  // Each string takes at least its 8-byte length.
+  TempFile words;
+  write_header(words, string(), 3);
+  EXPECT_THROW(read_binary<CircVector<string>>(words.fd), runtime_error);
+}
+TEST(BinaryIO, rejectsOversizedStringLengths) {
+  TempFile file;
+  BinaryHeader header = make_binary_header<string>(1);
+  uint64_t length = uint64_t(1) << 40;
+  write(file.fd, &header, sizeof(header));
+  write(file.fd, &length, sizeof(length));
+  write(file.fd, "abc", 3);
+
+  file.rewind();
+  EXPECT_THROW(read_binary<CircVector<string>>(file.fd), runtime_error);
+  file.rewind();
+  EXPECT_THROW(read_binary<LinkedList<string>>(file.fd), runtime_error);
+}
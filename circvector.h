@@ -1,59 +1,742 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <ranges>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#include "alignedallocator.h"
+#include "opstats.h"
+#include "rangeformat.h"
+#include "simdscan.h"
 
 using namespace std;
 
+/**
+ * How a full `CircVector` picks its next capacity, and when a draining one
+ * gives memory back. Each `CircVector` carries its own policy, so memory can
+ * be traded against reallocation frequency per instance.
+ *
+ * - `Double` (the default) doubles the capacity.
+ * - `OneAndHalf` grows by half the capacity.
+ * - `FixedIncrement` adds `increment` slots.
+ * - `PageRounded` doubles, then rounds the buffer up to whole pages of
+ *   `page_size` bytes.
+ *
+ * In power-of-two mode the result is still rounded up to a power of two, so
+ * there `OneAndHalf` behaves like `Double` and `FixedIncrement` only matters
+ * for increments larger than the capacity.
+ *
+ * With a nonzero `shrink_divisor`, `pop_front`, `pop_back` and `clear`
+ * reallocate once the size falls to `capacity / shrink_divisor` or below,
+ * down to twice the size (never below the default capacity). Shrinking to
+ * double the size leaves room to grow back before the next reallocation, so
+ * a ring that hovers around one size does not thrash; for the same reason
+ * `shrink_divisor` must be 0 or at least 3.
+ */
+struct GrowthPolicy {
+  enum Kind { Double, OneAndHalf, FixedIncrement, PageRounded };
+
+  static constexpr size_t page_size = 4096;
+
+  Kind kind = Double;
+  size_t increment = 1024;
+  size_t shrink_divisor = 0;
+};
+
+/**
+ * Uninitialized room for `N` elements of `T` inside a `CircVector`. Empty
+ * when `N` is 0.
+ */
+template <typename T, size_t N>
+struct InlineBuffer {
+  alignas(T) unsigned char bytes[N * sizeof(T)];
+
+  T *get() {
+    return reinterpret_cast<T *>(bytes);
+  }
+};
+
 template <typename T>
+struct InlineBuffer<T, 0> {
+  T *get() {
+    return nullptr;
+  }
+};
+
+/**
+ * Growable ring buffer. With `PowerOfTwo` set (the default), the capacity is
+ * always a power of two, so wrapping an index is a bitmask instead of an
+ * integer division.
+ *
+ * The buffer is raw storage: only the `vec_size` slots in the ring hold live
+ * objects. Elements are constructed when pushed and destroyed when popped,
+ * removed or cleared, so `T` need not be default-constructible.
+ *
+ * The buffer and the elements are allocated and constructed through `Alloc`,
+ * so the ring can live in an arena or a `std::pmr` memory resource
+ * (`PmrCircVector`), or in cache-line-aligned storage (`AlignedCircVector`).
+ * Copies and assignments follow the allocator's propagation traits, like
+ * the standard containers.
+ *
+ * With a nonzero `InlineCapacity` (see `SmallCircVector`), a buffer of that
+ * many slots (rounded up to a power of two in power-of-two mode) lives
+ * inside the object. It is the starting buffer and is used whenever the
+ * elements fit in it, so a vector that never outgrows it never allocates;
+ * the allocator is only used for larger buffers.
+ */
+template <typename T, bool PowerOfTwo = true, typename Alloc = allocator<T>,
+          size_t InlineCapacity = 0>
 class CircVector {
  private:
+  using AllocTraits = allocator_traits<Alloc>;
+
+  static constexpr size_t inline_slots =
+      (PowerOfTwo && InlineCapacity > 0) ? bit_ceil(InlineCapacity)
+                                         : InlineCapacity;
+
   T *data;
   size_t vec_size;
   size_t capacity;
   size_t front_idx;
+  GrowthPolicy growth;
+  [[no_unique_address]] Alloc alloc;
+  [[no_unique_address]] mutable OpCounters counters;
+  [[no_unique_address]] InlineBuffer<T, inline_slots> local;
+
+  /**
+   * Maps an unwrapped position, which may run past the end of `data`, onto a
+   * slot in `data`.
+   */
+  size_t wrap(size_t i) const {
+    if constexpr (PowerOfTwo) {
+      return i & (capacity - 1);
+    }
+    else {
+      return i % capacity;
+    }
+  }
+
+  /**
+   * Returns the capacity actually used for a requested one: rounded up to a
+   * power of two in power-of-two mode, unchanged otherwise, and never less
+   * than the inline buffer. Every buffer size goes through here, so this is
+   * where requests beyond `max_size()` are turned away with `length_error`
+   * (in power-of-two mode they would otherwise overflow `bit_ceil`).
+   */
+  static size_t round_capacity(size_t requested) {
+    if (requested > max_size()) {
+      throw length_error("CircVector capacity exceeds max_size()");
+    }
+    if constexpr (PowerOfTwo) {
+      return max(bit_ceil(requested), inline_slots);
+    }
+    else {
+      return max(requested, inline_slots);
+    }
+  }
+
+  /**
+   * Returns the capacity of a new, empty `CircVector`: the inline buffer if
+   * there is one, 10 slots (16 in power-of-two mode) otherwise.
+   */
+  static size_t initial_capacity() {
+    return (inline_slots > 0) ? inline_slots : round_capacity(10);
+  }
+
+  /**
+   * Allocates uninitialized storage for `n` elements from `alloc`, or hands
+   * out the inline buffer if `n` fits in it. Capacities always go through
+   * `round_capacity`, so the inline buffer is only asked for when it is not
+   * in use.
+   */
+  T *allocate_buffer(size_t n) {
+    if (n == 0) {
+      return nullptr;
+    }
+    if constexpr (inline_slots > 0) {
+      if (n <= inline_slots) {
+        return local.get();
+      }
+    }
+    return AllocTraits::allocate(alloc, n);
+  }
+
+  /**
+   * Frees `n` elements' worth of storage from `allocate_buffer`. Does not
+   * destroy any elements.
+   */
+  void deallocate_buffer(T *buffer, size_t n) {
+    if (buffer != nullptr && buffer != local.get()) {
+      AllocTraits::deallocate(alloc, buffer, n);
+    }
+  }
+
+  /**
+   * Frees the buffer and leaves the `CircVector` empty with no buffer. Does
+   * not destroy any elements.
+   */
+  void release_buffer() {
+    deallocate_buffer(data, capacity);
+    data = nullptr;
+    vec_size = 0;
+    capacity = 0;
+    front_idx = 0;
+  }
+
+  /**
+   * Takes over the buffer of `other`, leaving it empty with no buffer (or
+   * with its inline buffer, if it has one). The caller must have released
+   * our own buffer, and make sure the buffer can be freed through our
+   * allocator. Elements in `other`'s inline buffer cannot be taken over and
+   * are moved into ours instead.
+   */
+  void steal_from(CircVector &other) {
+    growth = other.growth;
+    if (inline_slots > 0 && other.data == other.local.get()) {
+      data = local.get();
+      capacity = inline_slots;
+      front_idx = 0;
+      other.move_out(data, 0, other.vec_size);
+    }
+    else {
+      data = other.data;
+      capacity = other.capacity;
+      front_idx = other.front_idx;
+    }
+    vec_size = other.vec_size;
+    counters.note_size(vec_size);
+    counters.note_capacity(capacity);
 
-  // TODO_STUDENT: add private helper functions, such as resize
-  // You may also find a "wrapping" function helpful.
-  void resize() {
-    size_t new_capacity = capacity * 2;
-    T* new_data = new T[new_capacity];
+    other.data = other.local.get();
+    other.vec_size = 0;
+    other.capacity = inline_slots;
+    other.front_idx = 0;
+  }
 
+  /**
+   * Destroys every live element, leaving the buffer allocated.
+   */
+  void destroy_elements() {
     for (size_t i = 0; i < vec_size; i++) {
-      new_data[i] = data[(front_idx + i) % capacity];
+      AllocTraits::destroy(alloc, data + wrap(front_idx + i));
+    }
+  }
+
+  /**
+   * Copy-constructs the elements of `other` into our (empty) buffer, which
+   * must be at least as large as `other.vec_size`. `vec_size` counts the
+   * elements as they are built, so if a copy throws, the ones already built
+   * are still owned and get destroyed.
+   */
+  void copy_elements(const CircVector &other) {
+    for (size_t i = 0; i < other.vec_size; i++) {
+      AllocTraits::construct(alloc, data + wrap(front_idx + i),
+                             other.data[other.wrap(other.front_idx + i)]);
+      vec_size++;
+    }
+  }
+
+  /**
+   * Moves the `count` elements starting at logical position `from` into
+   * consecutive slots starting at `dest`, destroying the originals. Trivially
+   * copyable elements are copied with at most two `memcpy`s.
+   */
+  void move_out(T *dest, size_t from, size_t count) {
+    if constexpr (is_trivially_copyable_v<T>) {
+      if (count == 0) {
+        return;
+      }
+      size_t start = wrap(front_idx + from);
+      size_t first = min(count, capacity - start);
+      memcpy(dest, data + start, first * sizeof(T));
+      memcpy(dest + first, data, (count - first) * sizeof(T));
     }
-    delete[] data;
+    else {
+      for (size_t i = 0; i < count; i++) {
+        T *elem = data + wrap(front_idx + from + i);
+        AllocTraits::construct(alloc, dest + i, std::move(*elem));
+        AllocTraits::destroy(alloc, elem);
+      }
+    }
+  }
+
+  /**
+   * Moves every element into `new_data` (of `new_capacity` slots) starting
+   * at slot 0, leaving slot `gap` unconstructed when `gap < vec_size`, then
+   * frees the old buffer.
+   */
+  void relocate(T *new_data, size_t new_capacity, size_t gap) {
+    counters.add_resize(vec_size * sizeof(T));
+    counters.note_capacity(new_capacity);
+    size_t before = min(gap, vec_size);
+    move_out(new_data, 0, before);
+    move_out(new_data + before + 1, before, vec_size - before);
+    deallocate_buffer(data, capacity);
     data = new_data;
     capacity = new_capacity;
     front_idx = 0;
   }
 
+  /**
+   * Copy-constructs the `n` elements at `src` onto the back, which must
+   * already have room for them, filling at most two contiguous runs of
+   * `data`. Trivially copyable elements are copied with `memcpy`.
+   */
+  void append_contiguous(const T *src, size_t n) {
+    if (n == 0) {
+      return;
+    }
+    size_t back = wrap(front_idx + vec_size);
+    size_t first = min(n, capacity - back);
+    if constexpr (is_trivially_copyable_v<T>) {
+      memcpy(data + back, src, first * sizeof(T));
+      memcpy(data, src + first, (n - first) * sizeof(T));
+      vec_size += n;
+    }
+    else {
+      // Count each element as it is built, so a throwing copy leaves only
+      // fully constructed elements behind.
+      for (size_t i = 0; i < first; i++) {
+        AllocTraits::construct(alloc, data + back + i, src[i]);
+        vec_size++;
+      }
+      for (size_t i = first; i < n; i++) {
+        AllocTraits::construct(alloc, data + (i - first), src[i]);
+        vec_size++;
+      }
+    }
+    counters.note_size(vec_size);
+  }
+
+  /**
+   * Constructs `n` elements from `it` onto the back, which must already have
+   * room for them, filling at most two contiguous runs of `data`.
+   */
+  template <typename It>
+  void append_from(It it, size_t n) {
+    if (n == 0) {
+      return;
+    }
+    size_t back = wrap(front_idx + vec_size);
+    size_t first = min(n, capacity - back);
+    for (size_t i = 0; i < first; i++, ++it) {
+      AllocTraits::construct(alloc, data + back + i, *it);
+      vec_size++;
+    }
+    for (size_t i = first; i < n; i++, ++it) {
+      AllocTraits::construct(alloc, data + (i - first), *it);
+      vec_size++;
+    }
+    counters.note_size(vec_size);
+  }
+
+  /**
+   * Returns the position of the first element of `run` equal to `value`, or
+   * `run.size()` if there is none.
+   */
+  static size_t scan_find(span<const T> run, const T &value) {
+    if constexpr (simd_scannable<T>) {
+      return simd_find(run.data(), run.size(), value);
+    }
+    else {
+      return std::find(run.begin(), run.end(), value) - run.begin();
+    }
+  }
+
+  /**
+   * Returns the position of the last element of `run` equal to `value`, or
+   * `run.size()` if there is none.
+   */
+  static size_t scan_find_last(span<const T> run, const T &value) {
+    if constexpr (simd_scannable<T>) {
+      return simd_find_last(run.data(), run.size(), value);
+    }
+    else {
+      for (size_t i = run.size(); i > 0; i--) {
+        if (run[i - 1] == value) {
+          return i - 1;
+        }
+      }
+      return run.size();
+    }
+  }
+
+  /**
+   * Returns the capacity to grow to when the buffer is full, following the
+   * growth policy.
+   */
+  size_t grown_capacity() const {
+    if (capacity == 0) {
+      return initial_capacity();
+    }
+    size_t next = capacity * 2;
+    switch (growth.kind) {
+      case GrowthPolicy::Double:
+        break;
+      case GrowthPolicy::OneAndHalf:
+        next = capacity + max<size_t>(capacity / 2, 1);
+        break;
+      case GrowthPolicy::FixedIncrement:
+        next = capacity + max<size_t>(growth.increment, 1);
+        break;
+      case GrowthPolicy::PageRounded: {
+        size_t page = GrowthPolicy::page_size;
+        size_t bytes = (next * sizeof(T) + page - 1) / page * page;
+        next = bytes / sizeof(T);
+        break;
+      }
+    }
+    return round_capacity(next);
+  }
+
+  /**
+   * Returns the size after adding `n` elements, or throws `length_error` if
+   * that would exceed `max_size()` (or wrap around).
+   */
+  size_t size_after_adding(size_t n) const {
+    if (n > max_size() - vec_size) {
+      throw length_error("CircVector size exceeds max_size()");
+    }
+    return vec_size + n;
+  }
+
+  /**
+   * Moves the elements into a buffer of `new_capacity` slots, which must
+   * hold them all.
+   */
+  void reallocate(size_t new_capacity) {
+    relocate(allocate_buffer(new_capacity), new_capacity, vec_size);
+  }
+
+  /**
+   * Applies the auto-shrink part of the growth policy after elements were
+   * removed. A failed allocation just leaves the buffer as it is.
+   */
+  void maybe_shrink() {
+    if (growth.shrink_divisor == 0 ||
+        vec_size > capacity / growth.shrink_divisor) {
+      return;
+    }
+    size_t target = round_capacity(max(vec_size * 2, size_t(10)));
+    if (target >= capacity) {
+      return;
+    }
+    try {
+      reallocate(target);
+    }
+    catch (const bad_alloc &) {
+    }
+  }
+
+  /**
+   * Constructs a new element from `args` at logical position `pos`
+   * (`0 <= pos <= vec_size`) and returns a reference to it. Whichever side
+   * of `pos` is shorter moves over by one slot: the elements before it
+   * towards the front, with `front_idx` stepping back, or the elements from
+   * it on towards the back. When the buffer is full, the element is built
+   * directly in the new buffer, so `args` may refer to elements of this
+   * `CircVector`.
+   */
+  template <typename... Args>
+  T &emplace_at(size_t pos, Args &&...args) {
+    if (vec_size == capacity) {
+      size_t new_capacity = grown_capacity();
+      T *new_data = allocate_buffer(new_capacity);
+      try {
+        AllocTraits::construct(alloc, new_data + pos,
+                               std::forward<Args>(args)...);
+      }
+      catch (...) {
+        deallocate_buffer(new_data, new_capacity);
+        throw;
+      }
+      relocate(new_data, new_capacity, pos);
+      vec_size++;
+      counters.note_size(vec_size);
+      return data[pos];
+    }
+
+    if (pos == vec_size) {
+      size_t slot = wrap(front_idx + vec_size);
+      AllocTraits::construct(alloc, data + slot,
+                             std::forward<Args>(args)...);
+      vec_size++;
+      counters.note_size(vec_size);
+      return data[slot];
+    }
+
+    if (pos == 0) {
+      size_t slot = wrap(front_idx + capacity - 1);
+      AllocTraits::construct(alloc, data + slot,
+                             std::forward<Args>(args)...);
+      front_idx = slot;
+      vec_size++;
+      counters.note_size(vec_size);
+      return data[slot];
+    }
+
+    T elem(std::forward<Args>(args)...);
+    if (pos < vec_size - pos) {
+      counters.add_shifted(pos);
+      size_t new_front = wrap(front_idx + capacity - 1);
+      AllocTraits::construct(alloc, data + new_front,
+                             std::move(data[front_idx]));
+      for (size_t i = 1; i < pos; i++) {
+        data[wrap(front_idx + i - 1)] = std::move(data[wrap(front_idx + i)]);
+      }
+      size_t slot = wrap(front_idx + pos - 1);
+      data[slot] = std::move(elem);
+      front_idx = new_front;
+      vec_size++;
+      counters.note_size(vec_size);
+      return data[slot];
+    }
+
+    counters.add_shifted(vec_size - pos);
+    size_t back = wrap(front_idx + vec_size);
+    AllocTraits::construct(alloc, data + back,
+                           std::move(data[wrap(back + capacity - 1)]));
+    for (size_t i = vec_size - 1; i > pos; i--) {
+      data[wrap(front_idx + i)] = std::move(data[wrap(front_idx + i - 1)]);
+    }
+    size_t slot = wrap(front_idx + pos);
+    data[slot] = std::move(elem);
+    vec_size++;
+    counters.note_size(vec_size);
+    return data[slot];
+  }
+
  public:
   /**
-   * Default constructor. Creates an empty `CircVector` with capacity 10.
+   * Random-access iterator over the elements in logical order. It keeps a
+   * raw pointer into the buffer alongside the logical index, so stepping
+   * only has to check for the end of the buffer instead of wrapping every
+   * access; jumps of any size wrap with a single compare.
    */
-  CircVector() {
+  template <bool IsConst>
+  class Iterator {
+   private:
+    using Ptr = conditional_t<IsConst, const T *, T *>;
+
+    Ptr ptr = nullptr;
+    Ptr buf_begin = nullptr;
+    Ptr buf_end = nullptr;
+    ptrdiff_t index = 0;
+
+    friend class CircVector;
+    friend class Iterator<!IsConst>;
+
+    Iterator(Ptr ptr, Ptr buf_begin, Ptr buf_end, ptrdiff_t index)
+        : ptr(ptr), buf_begin(buf_begin), buf_end(buf_end), index(index) {
+    }
+
+   public:
+    using iterator_category = random_access_iterator_tag;
+    using iterator_concept = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = Ptr;
+    using reference = conditional_t<IsConst, const T &, T &>;
+
+    Iterator() = default;
+
+    /**
+     * Converts an `iterator` to a `const_iterator`.
+     */
+    template <bool OtherConst>
+      requires(IsConst && !OtherConst)
+    Iterator(const Iterator<OtherConst> &other)
+        : ptr(other.ptr),
+          buf_begin(other.buf_begin),
+          buf_end(other.buf_end),
+          index(other.index) {
+    }
+
+    reference operator*() const {
+      return *ptr;
+    }
+
+    pointer operator->() const {
+      return ptr;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    Iterator &operator++() {
+      index++;
+      if (++ptr == buf_end) {
+        ptr = buf_begin;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    Iterator &operator--() {
+      index--;
+      if (ptr == buf_begin) {
+        ptr = buf_end;
+      }
+      --ptr;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --*this;
+      return old;
+    }
+
+    Iterator &operator+=(difference_type n) {
+      // Valid iterators never move more than one capacity, so a single
+      // correction in either direction is enough.
+      difference_type cap = buf_end - buf_begin;
+      difference_type offset = (ptr - buf_begin) + n;
+      if (offset >= cap) {
+        offset -= cap;
+      }
+      else if (offset < 0) {
+        offset += cap;
+      }
+      ptr = buf_begin + offset;
+      index += n;
+      return *this;
+    }
+
+    Iterator &operator-=(difference_type n) {
+      return *this += -n;
+    }
+
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+
+    friend difference_type operator-(const Iterator &a, const Iterator &b) {
+      return a.index - b.index;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+
+    friend strong_ordering operator<=>(const Iterator &a, const Iterator &b) {
+      return a.index <=> b.index;
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+ private:
+  /**
+   * Returns an iterator to logical position `index` (`0 <= index <=
+   * vec_size`).
+   */
+  template <bool IsConst>
+  Iterator<IsConst> make_iterator(size_t index) const {
+    T *slot = (capacity == 0) ? data : data + wrap(front_idx + index);
+    return Iterator<IsConst>(slot, data, data + capacity, index);
+  }
+
+ public:
+  using allocator_type = Alloc;
+
+  /**
+   * Default constructor. Creates an empty `CircVector` with capacity 10
+   * (16 in power-of-two mode), or with just its inline buffer if it has one,
+   * in which case nothing is allocated.
+   */
+  CircVector() : CircVector(Alloc()) {
+  }
+
+  /**
+   * Creates an empty `CircVector` with the default capacity, allocating from
+   * `alloc`.
+   */
+  explicit CircVector(const Alloc &alloc) : alloc(alloc) {
     vec_size = 0;
-    capacity = 10;
+    capacity = initial_capacity();
     front_idx = 0;
-    data = new T[capacity];
+    data = allocate_buffer(capacity);
+    counters.note_capacity(capacity);
   }
 
   /**
    * Creates an empty `CircVector` with given capacity. Capacity must exceed 0.
+   * In power-of-two mode the capacity is rounded up to the next power of two.
+   * A capacity that fits in the inline buffer uses the inline buffer. Throws
+   * `length_error` if the capacity exceeds `max_size()`.
    */
-  CircVector(size_t capacity) {
+  CircVector(size_t capacity, const Alloc &alloc = Alloc()) : alloc(alloc) {
     if (capacity > 0) {
-      this->capacity = capacity;
+      this->capacity = round_capacity(capacity);
     }
     else {
       cout << "Capacity must be > 0" << endl;
+      this->capacity = round_capacity(1);
     }
     vec_size = 0;
     front_idx = 0;
-    data = new T[capacity];
+    data = allocate_buffer(this->capacity);
+    counters.note_capacity(this->capacity);
+  }
+
+  /**
+   * Creates a `CircVector` holding a copy of every element of `range`, in
+   * order, with a single allocation when the size of `range` is known up
+   * front.
+   */
+  template <ranges::input_range R>
+    requires(!is_same_v<remove_cvref_t<R>, CircVector> &&
+             constructible_from<T, ranges::range_reference_t<R>>)
+  explicit CircVector(R &&range, const Alloc &alloc = Alloc()) : alloc(alloc) {
+    vec_size = 0;
+    front_idx = 0;
+    capacity = 0;
+    data = nullptr;
+    if constexpr (ranges::sized_range<R> || ranges::forward_range<R>) {
+      reserve(max<size_t>(ranges::distance(range), 1));
+    }
+    else {
+      reserve(initial_capacity());
+    }
+    try {
+      append(std::forward<R>(range));
+    }
+    catch (...) {
+      destroy_elements();
+      deallocate_buffer(data, capacity);
+      throw;
+    }
   }
 
   /**
@@ -71,29 +754,60 @@ class CircVector {
     return vec_size;
   }
 
+  /**
+   * Returns the largest capacity a `CircVector` can have: the most elements
+   * whose size in bytes fits in a `size_t`, rounded down to a power of two
+   * in power-of-two mode.
+   */
+  static constexpr size_t max_size() {
+    size_t most = numeric_limits<size_t>::max() / sizeof(T);
+    return PowerOfTwo ? bit_floor(most) : most;
+  }
+
   /**
    * Adds the given `T` to the front of the `CircVector`.
    */
-  void push_front(T elem) {
-    if (capacity == vec_size) {
-      resize();
-    }
-    front_idx = (front_idx + capacity - 1) % capacity;
-    
-    data[front_idx] = elem;
+  void push_front(const T &elem) {
+    emplace_front(elem);
+  }
 
-    vec_size++;
+  /**
+   * Moves the given `T` onto the front of the `CircVector`.
+   */
+  void push_front(T &&elem) {
+    emplace_front(std::move(elem));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments at the front of the
+   * `CircVector`, and returns a reference to it.
+   */
+  template <typename... Args>
+  T &emplace_front(Args &&...args) {
+    return emplace_at(0, std::forward<Args>(args)...);
   }
 
   /**
    * Adds the given `T` to the back of the `CircVector`.
    */
-  void push_back(T elem) {
-    if (capacity == vec_size) {
-      resize();
-    }
-    data[(front_idx + vec_size) % capacity] = elem;
-    vec_size++;
+  void push_back(const T &elem) {
+    emplace_back(elem);
+  }
+
+  /**
+   * Moves the given `T` onto the back of the `CircVector`.
+   */
+  void push_back(T &&elem) {
+    emplace_back(std::move(elem));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments at the back of the
+   * `CircVector`, and returns a reference to it.
+   */
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    return emplace_at(vec_size, std::forward<Args>(args)...);
   }
 
   /**
@@ -105,9 +819,11 @@ class CircVector {
     if (vec_size == 0) {
       throw runtime_error("Vector is empty");
     }
-    T value = data[front_idx];
-    front_idx = (front_idx + 1) % capacity;
+    T value = std::move(data[front_idx]);
+    AllocTraits::destroy(alloc, data + front_idx);
+    front_idx = wrap(front_idx + 1);
     vec_size--;
+    maybe_shrink();
     return value;
   }
 
@@ -120,29 +836,31 @@ class CircVector {
     if (vec_size == 0) {
       throw runtime_error("Vector is empty");
     }
-    size_t back_idx = (front_idx + vec_size - 1) % capacity;
-    T value = data[back_idx];
+    size_t back_idx = wrap(front_idx + vec_size - 1);
+    T value = std::move(data[back_idx]);
+    AllocTraits::destroy(alloc, data + back_idx);
     vec_size--;
+    maybe_shrink();
     return value;
   }
 
   /**
-   * Removes all elements from the `CircVector`.
+   * Removes all elements from the `CircVector`, destroying them. The buffer
+   * is kept, unless the growth policy asks for auto-shrinking.
    */
   void clear() {
+    destroy_elements();
     vec_size = 0;
     front_idx = 0;
+    maybe_shrink();
   }
 
   /**
    * Destructor. Clears all allocated memory.
    */
   ~CircVector() {
-    delete[] data;
-    data = nullptr;
-    capacity = 0;
-    front_idx = 0;
-    vec_size = 0;
+    destroy_elements();
+    release_buffer();
   }
 
   /**
@@ -154,29 +872,53 @@ class CircVector {
     if (index < 0 || index >= vec_size) {
       throw out_of_range("Index is out of range");
     };
-    return data[(front_idx + index) % capacity];
+    return data[wrap(front_idx + index)];
   }
 
   /**
-   * Copy constructor. Creates a deep copy of the given `CircVector`.
+   * Copy constructor. Creates a deep copy of the given `CircVector`, with
+   * the allocator chosen by `select_on_container_copy_construction`.
    *
    * Must run in O(N) time.
    */
-  CircVector(const CircVector &other) {
-    vec_size = other.vec_size;
+  CircVector(const CircVector &other)
+      : alloc(AllocTraits::select_on_container_copy_construction(
+            other.alloc)) {
+    vec_size = 0;
     front_idx = other.front_idx;
     capacity = other.capacity;
+    growth = other.growth;
 
-    data = new T[capacity];
-
-    for (size_t i = 0; i < vec_size; i++) {
-      data[(front_idx + i) % capacity] = other.data[(other.front_idx + i) % capacity];
+    data = allocate_buffer(capacity);
+    counters.note_capacity(capacity);
+    try {
+      copy_elements(other);
+    }
+    catch (...) {
+      destroy_elements();
+      deallocate_buffer(data, capacity);
+      throw;
     }
+    counters.note_size(vec_size);
+  }
+
+  /**
+   * Move constructor. Takes over the buffer of the given `CircVector`, which
+   * is left empty. Runs in O(1) time, except that elements held in an
+   * inline buffer are moved one by one.
+   */
+  CircVector(CircVector &&other) noexcept(
+      inline_slots == 0 || is_nothrow_move_constructible_v<T>)
+      : alloc(other.alloc) {
+    steal_from(other);
   }
 
   /**
    * Assignment operator. Sets the current `CircVector` to a deep copy of the
-   * given `CircVector`.
+   * given `CircVector`, taking over its allocator too if
+   * `propagate_on_container_copy_assignment` says so.
+   * If an element copy throws, the `CircVector` keeps the elements copied
+   * so far.
    *
    * Must run in O(N) time.
    */
@@ -185,16 +927,66 @@ class CircVector {
       return *this;
     }
 
-    delete[] data;
+    destroy_elements();
+    release_buffer();
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+      alloc = other.alloc;
+    }
 
-    vec_size = other.vec_size;
+    // Allocate before touching our state, so that if it throws we are left
+    // empty, as `release_buffer()` made us.
+    data = allocate_buffer(other.capacity);
+    vec_size = 0;
     front_idx = other.front_idx;
     capacity = other.capacity;
+    growth = other.growth;
 
-    data = new T[capacity];
+    counters.note_capacity(capacity);
+    copy_elements(other);
+    counters.note_size(vec_size);
 
-    for (size_t i = 0; i < vec_size; i++) {
-      data[(front_idx + i) % capacity] = other.data[(other.front_idx + i) % capacity];
+    return *this;
+  }
+
+  /**
+   * Move assignment operator. Releases the current buffer and takes over the
+   * buffer of the given `CircVector`, which is left empty. Runs in O(1) time
+   * unless the two allocators differ and cannot be propagated, in which case
+   * the elements are moved one by one into a buffer of our own.
+   */
+  CircVector &operator=(CircVector &&other) noexcept(
+      (AllocTraits::propagate_on_container_move_assignment::value ||
+       AllocTraits::is_always_equal::value) &&
+      (inline_slots == 0 || is_nothrow_move_constructible_v<T>)) {
+    if (this == &other) {
+      return *this;
+    }
+
+    destroy_elements();
+    release_buffer();
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+      alloc = other.alloc;
+      steal_from(other);
+    }
+    else {
+      if (alloc == other.alloc) {
+        steal_from(other);
+      }
+      else {
+        // Allocate first, as in copy assignment.
+        data = allocate_buffer(other.capacity);
+        growth = other.growth;
+        capacity = other.capacity;
+        counters.note_capacity(capacity);
+        for (size_t i = 0; i < other.vec_size; i++) {
+          AllocTraits::construct(
+              alloc, data + i,
+              std::move(other.data[other.wrap(other.front_idx + i)]));
+          vec_size++;
+        }
+        counters.note_size(vec_size);
+        other.clear();
+      }
     }
 
     return *this;
@@ -206,33 +998,86 @@ class CircVector {
    * time.
    */
   string to_string() const {
-    stringstream ss;
-    ss << "[";
-    for (size_t i = 0; i < vec_size; i++) {
-      ss << data[(front_idx + i) % capacity];
-      if (i + 1 < vec_size){
-        ss << ", ";
-      }
-    }
-    ss << "]";
-    return ss.str();
+    string out;
+    write_to(out);
+    return out;
+  }
+
+  /**
+   * Appends the `to_string` form to `out`. Numbers are converted with
+   * `to_chars` straight into a stack buffer (see `rangeformat.h`), so
+   * reusing `out` across calls avoids allocating at all.
+   */
+  void write_to(string &out) const {
+    format_range(*this, [&](const char *p, size_t n) { out.append(p, n); });
+  }
+
+  /**
+   * Writes the `to_string` form to `os` without building the string first.
+   * The stream's formatting flags are not used, so the output always
+   * matches `to_string`.
+   */
+  void write_to(ostream &os) const {
+    format_range(*this, [&](const char *p, size_t n) { os.write(p, n); });
   }
 
   /**
    * Searches the `CircVector` for the first matching element, and returns its
    * index in the `CircVector`. If no match is found, returns "-1".
+   *
+   * Scans the two ring segments directly; for integral and floating-point
+   * `T` the scan is vectorized (see `simdscan.h`).
    */
-  size_t find(const T &target) {
-    for (size_t i = 0; i < vec_size; i++) {
-      if (data[(front_idx + i) % capacity] == target) {
-        return i;
-      }
+  size_t find(const T &target) const {
+    auto [first, second] = as_spans();
+    size_t i = scan_find(first, target);
+    if (i < first.size()) {
+      return i;
+    }
+    size_t j = scan_find(second, target);
+    return (j < second.size()) ? first.size() + j : -1;
+  }
+
+  /**
+   * Searches the `CircVector` for the last matching element, and returns its
+   * index. If no match is found, returns "-1". Vectorized like `find`.
+   */
+  size_t find_last(const T &target) const {
+    auto [first, second] = as_spans();
+    size_t j = scan_find_last(second, target);
+    if (j < second.size()) {
+      return first.size() + j;
     }
-    return -1;
+    size_t i = scan_find_last(first, target);
+    return (i < first.size()) ? i : -1;
   }
 
   /**
-   * Remove the element at the specified index in this list.
+   * Returns how many elements equal `target`. Vectorized like `find`.
+   */
+  size_t count(const T &target) const {
+    auto [first, second] = as_spans();
+    if constexpr (simd_scannable<T>) {
+      return simd_count(first.data(), first.size(), target) +
+             simd_count(second.data(), second.size(), target);
+    }
+    else {
+      return std::count(first.begin(), first.end(), target) +
+             std::count(second.begin(), second.end(), target);
+    }
+  }
+
+  /**
+   * Returns whether any element equals `target`.
+   */
+  bool contains(const T &target) const {
+    return find(target) != size_t(-1);
+  }
+
+  /**
+   * Remove the element at the specified index in this list. The shorter
+   * side closes the gap, so removing near either end is O(1) and anywhere
+   * else moves at most N/2 elements.
    *
    * If the index is invalid, throws `out_of_range`.
    */
@@ -240,30 +1085,105 @@ class CircVector {
     if (index < 0 || index >= vec_size) {
       throw out_of_range("Index is out of range");
     }
+    if (index < vec_size - 1 - index) {
+      counters.add_shifted(index);
+      for (size_t i = index; i > 0; i--) {
+        data[wrap(front_idx + i)] = std::move(data[wrap(front_idx + i - 1)]);
+      }
+      AllocTraits::destroy(alloc, data + front_idx);
+      front_idx = wrap(front_idx + 1);
+      vec_size--;
+      return;
+    }
+    counters.add_shifted(vec_size - 1 - index);
     for (size_t i = index; i + 1 < vec_size; i++) {
-      data[(front_idx + i) % capacity] = data[(front_idx + i + 1) % capacity];
+      data[wrap(front_idx + i)] = std::move(data[wrap(front_idx + i + 1)]);
     }
+    AllocTraits::destroy(alloc, data + wrap(front_idx + vec_size - 1));
     vec_size--;
   }
 
   /**
-   * Inserts the given `T` as a new element in the `CircVector` after
+   * Inserts the given `T` so that it ends up at the given index, which may
+   * be `size()` to append. Moves at most N/2 elements, and none at either
+   * end. If the index is invalid, throws `out_of_range`.
+   */
+  void insert_at(size_t index, const T &elem) {
+    if (index > vec_size) {
+      throw out_of_range("Index is out of range");
+    }
+    emplace_at(index, elem);
+  }
+
+  /**
+   * Moves the given `T` into the `CircVector` at the given index, which may
+   * be `size()` to append. If the index is invalid, throws `out_of_range`.
+   */
+  void insert_at(size_t index, T &&elem) {
+    if (index > vec_size) {
+      throw out_of_range("Index is out of range");
+    }
+    emplace_at(index, std::move(elem));
+  }
+
+  /**
+   * Inserts the given `T` as a new element in the `CircVector` before
    * the given index. If the index is invalid, throws `out_of_range`.
    */
-  void insert_after(size_t index, T elem) {
-    if (index < 0 || index >= vec_size) {
+  void insert_before(size_t index, const T &elem) {
+    emplace_before(index, elem);
+  }
+
+  /**
+   * Moves the given `T` into the `CircVector` before the given index. If the
+   * index is invalid, throws `out_of_range`.
+   */
+  void insert_before(size_t index, T &&elem) {
+    emplace_before(index, std::move(elem));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments as a new element before the
+   * given index, and returns a reference to it. If the index is invalid,
+   * throws `out_of_range`.
+   */
+  template <typename... Args>
+  T &emplace_before(size_t index, Args &&...args) {
+    if (index >= vec_size) {
       throw out_of_range("Index is out of range");
     }
 
-    if(vec_size == capacity) {
-        resize();
-      }
+    return emplace_at(index, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Inserts the given `T` as a new element in the `CircVector` after
+   * the given index. If the index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, const T &elem) {
+    emplace_after(index, elem);
+  }
+
+  /**
+   * Moves the given `T` into the `CircVector` after the given index. If the
+   * index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, T &&elem) {
+    emplace_after(index, std::move(elem));
+  }
 
-    for (size_t i = vec_size; i > index + 1; i--) {
-      data[(i + front_idx) % capacity] = data[(i + front_idx + capacity - 1) % capacity];
+  /**
+   * Constructs a `T` from the given arguments as a new element after the
+   * given index, and returns a reference to it. If the index is invalid,
+   * throws `out_of_range`.
+   */
+  template <typename... Args>
+  T &emplace_after(size_t index, Args &&...args) {
+    if (index < 0 || index >= vec_size) {
+      throw out_of_range("Index is out of range");
     }
-    data[(front_idx + index + 1) % capacity] = elem;
-    vec_size++;
+
+    return emplace_at(index + 1, std::forward<Args>(args)...);
   }
 
   /**
@@ -282,13 +1202,232 @@ class CircVector {
     size_t index = 0;
     for (size_t i = 0; i < vec_size; i++) {
       if (i % 2 != 0) {
-        data[(front_idx + index) % capacity] = data[(front_idx + i) % capacity];
+        data[wrap(front_idx + index)] = std::move(data[wrap(front_idx + i)]);
         index++;
       }
     }
+    for (size_t i = index; i < vec_size; i++) {
+      AllocTraits::destroy(alloc, data + wrap(front_idx + i));
+    }
     vec_size = index;
   }
 
+  /**
+   * Makes room for at least `n` elements without further reallocation. Does
+   * nothing if the capacity is already large enough; otherwise reallocates
+   * once (rounding up in power-of-two mode) and moves the elements to the
+   * start of the new buffer. Throws `length_error` if `n` exceeds
+   * `max_size()`, leaving the `CircVector` unchanged.
+   */
+  void reserve(size_t n) {
+    if (n <= capacity) {
+      return;
+    }
+    reallocate(round_capacity(n));
+  }
+
+  /**
+   * Releases unused capacity: reallocates to exactly the current size
+   * (rounded up in power-of-two mode, and at least one slot). Does nothing
+   * if that would not make the buffer smaller.
+   */
+  void shrink_to_fit() {
+    size_t target = round_capacity(max<size_t>(vec_size, 1));
+    if (target < capacity) {
+      reallocate(target);
+    }
+  }
+
+  /**
+   * Returns the growth policy in use.
+   */
+  const GrowthPolicy &get_growth_policy() const {
+    return growth;
+  }
+
+  /**
+   * Replaces the growth policy. It applies from the next reallocation on;
+   * the current buffer is left alone. Copies and assignments carry the
+   * policy along.
+   *
+   * If `policy.shrink_divisor` is 1 or 2, throws `invalid_argument`.
+   */
+  void set_growth_policy(const GrowthPolicy &policy) {
+    if (policy.shrink_divisor == 1 || policy.shrink_divisor == 2) {
+      throw invalid_argument("shrink_divisor must be 0 or at least 3");
+    }
+    growth = policy;
+  }
+
+  /**
+   * Returns a snapshot of this `CircVector`'s operation counters (see
+   * `opstats.h`). All zeros unless built with `CONTAINER_STATS`.
+   */
+  OpStats stats() const {
+    return counters.snapshot();
+  }
+
+  /**
+   * Zeroes the operation counters. The peaks restart from the current size
+   * and capacity.
+   */
+  void reset_stats() {
+    counters.reset();
+    counters.note_size(vec_size);
+    counters.note_capacity(capacity);
+  }
+
+  /**
+   * Copies every element of `range` onto the back, in order. When the size
+   * of `range` is known up front, the final capacity is computed once (at
+   * least one growth step, as `push_back` would take), so there is at most one
+   * reallocation, and the new elements are copied into at most two
+   * contiguous runs of the buffer; contiguous ranges and other `CircVector`s
+   * of trivially copyable `T` are copied with `memcpy`. Other input ranges
+   * fall back to `emplace_back` per element.
+   *
+   * `range` must not refer to elements of this `CircVector`.
+   */
+  template <ranges::input_range R>
+    requires constructible_from<T, ranges::range_reference_t<R>>
+  void append(R &&range) {
+    if constexpr (ranges::sized_range<R> || ranges::forward_range<R>) {
+      size_t n = ranges::distance(range);
+      size_t new_size = size_after_adding(n);
+      if (new_size > capacity) {
+        reserve(max(new_size, grown_capacity()));
+      }
+      using Elem = remove_cvref_t<ranges::range_reference_t<R>>;
+      if constexpr (ranges::contiguous_range<R> && is_same_v<Elem, T>) {
+        append_contiguous(ranges::data(range), n);
+      }
+      else if constexpr (requires { range.as_spans(); } && is_same_v<Elem, T>) {
+        auto [first, second] = range.as_spans();
+        append_contiguous(first.data(), first.size());
+        append_contiguous(second.data(), second.size());
+      }
+      else {
+        append_from(ranges::begin(range), n);
+      }
+    }
+    else {
+      for (auto &&elem : range) {
+        emplace_back(std::forward<decltype(elem)>(elem));
+      }
+    }
+  }
+
+  /**
+   * Appends `n` elements written in place by `fill`, with at most one
+   * reallocation. `fill(dest, count)` is called once or twice, for each
+   * contiguous run of free slots at the back, in logical order, and must
+   * store `count` elements at `dest`. If it throws, the size is unchanged.
+   * This is how bulk loaders (`binaryio.h`) read straight into the buffer.
+   */
+  template <typename Fill>
+    requires is_trivially_copyable_v<T>
+  void append_uninitialized(size_t n, Fill fill) {
+    if (n == 0) {
+      return;
+    }
+    size_t new_size = size_after_adding(n);
+    if (new_size > capacity) {
+      reserve(max(new_size, grown_capacity()));
+    }
+    size_t back = wrap(front_idx + vec_size);
+    size_t first = min(n, capacity - back);
+    fill(data + back, first);
+    if (first < n) {
+      fill(data, n - first);
+    }
+    vec_size += n;
+    counters.note_size(vec_size);
+  }
+
+  /**
+   * Replaces the contents with a copy of every element of `range`, in order.
+   * Reallocates at most once, only when `range` does not fit in the current
+   * buffer, and then straight to its size (rounded up in power-of-two mode).
+   *
+   * `range` must not refer to elements of this `CircVector`.
+   */
+  template <ranges::input_range R>
+    requires constructible_from<T, ranges::range_reference_t<R>>
+  void assign(R &&range) {
+    clear();
+    if constexpr (ranges::sized_range<R> || ranges::forward_range<R>) {
+      size_t n = ranges::distance(range);
+      if (n > capacity) {
+        size_t new_capacity = round_capacity(n);
+        T *new_data = allocate_buffer(new_capacity);
+        deallocate_buffer(data, capacity);
+        data = new_data;
+        capacity = new_capacity;
+        counters.note_capacity(capacity);
+      }
+    }
+    append(std::forward<R>(range));
+  }
+
+  /**
+   * Returns an iterator to the first element.
+   */
+  iterator begin() {
+    return make_iterator<false>(0);
+  }
+
+  /**
+   * Returns an iterator one past the last element.
+   */
+  iterator end() {
+    return make_iterator<false>(vec_size);
+  }
+
+  const_iterator begin() const {
+    return make_iterator<true>(0);
+  }
+
+  const_iterator end() const {
+    return make_iterator<true>(vec_size);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  /**
+   * Returns the contents as two contiguous runs of `data`: the first covers
+   * the elements from `front_idx` up to the end of the buffer, the second the
+   * elements that wrapped around to the start. Concatenated, they are the
+   * elements in logical order; the second is empty if nothing wraps. The
+   * spans are invalidated by any operation that adds or removes elements.
+   */
+  pair<span<T>, span<T>> as_spans() {
+    size_t first = min(vec_size, capacity - front_idx);
+    return {span<T>(data + front_idx, first),
+            span<T>(data, vec_size - first)};
+  }
+
+  /**
+   * Read-only version of `as_spans()`.
+   */
+  pair<span<const T>, span<const T>> as_spans() const {
+    size_t first = min(vec_size, capacity - front_idx);
+    return {span<const T>(data + front_idx, first),
+            span<const T>(data, vec_size - first)};
+  }
+
+  /**
+   * Returns a copy of the allocator.
+   */
+  Alloc get_allocator() const {
+    return alloc;
+  }
+
   /**
    * Returns a pointer to the underlying memory managed by the `CircVec`.
    * For autograder testing purposes only. Do not change.
@@ -304,4 +1443,47 @@ class CircVector {
   size_t get_capacity() const {
     return this->capacity;
   }
-};
\ No newline at end of file
+};
+
+/**
+ * `CircVector` allocating from a `std::pmr::memory_resource`, such as a
+ * `monotonic_buffer_resource` arena. Elements that are allocator-aware
+ * themselves (`pmr::string`, ...) get the same resource.
+ */
+template <typename T, bool PowerOfTwo = true>
+using PmrCircVector = CircVector<T, PowerOfTwo, pmr::polymorphic_allocator<T>>;
+
+/**
+ * `CircVector` whose buffer starts on a cache line, so that 32- and 64-byte
+ * elements never straddle two lines.
+ */
+template <typename T, bool PowerOfTwo = true>
+using AlignedCircVector = CircVector<T, PowerOfTwo, AlignedAllocator<T>>;
+
+/**
+ * `CircVector` with room for `N` elements inside the object (rounded up to a
+ * power of two in power-of-two mode). Constructing one allocates nothing, and
+ * it only goes to the heap once it outgrows the inline buffer; popping back
+ * down and calling `shrink_to_fit` returns to it. Moving one that is still
+ * inline moves its elements one by one.
+ */
+template <typename T, size_t N, bool PowerOfTwo = true>
+using SmallCircVector = CircVector<T, PowerOfTwo, allocator<T>, N>;
+
+#ifdef __cpp_lib_format
+/**
+ * `std::format("{}", c)` prints the `to_string` form.
+ */
+namespace std {
+template <typename T, bool PowerOfTwo, typename Alloc, size_t N>
+struct formatter<CircVector<T, PowerOfTwo, Alloc, N>, char>
+    : RangeFormatter {};
+
+#ifdef __cpp_lib_format_ranges
+// Keep the generic range formatter out of the way.
+template <typename T, bool PowerOfTwo, typename Alloc, size_t N>
+inline constexpr range_format
+    format_kind<CircVector<T, PowerOfTwo, Alloc, N>> = range_format::disabled;
+#endif
+}  // namespace std
+#endif
@@ -1,6 +1,18 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <list>
+#include <memory_resource>
+#include <numeric>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include "circvector.h"
 
 using namespace std;
@@ -402,4 +414,977 @@ TEST(CircVectorExtras, removeEvensValuesAndSize) {
   EXPECT_THAT(v.at(0), Eq(2));
   EXPECT_THAT(v.at(1), Eq(4));
   EXPECT_THAT(v.at(2), Eq(6));
-}
\ No newline at end of file
+}
+//Capacity
+TEST(CircVectorCapacity, roundsUpToPowerOfTwo) {
+  CircVector<int> v(5);
+  EXPECT_THAT(v.get_capacity(), Eq(8));
+
+  CircVector<int> v2;
+  EXPECT_THAT(v2.get_capacity(), Eq(16));
+
+  CircVector<int> v3(4);
+  for (int i = 0; i < 5; i++) {
+    v3.push_back(i);
+  }
+  EXPECT_THAT(v3.get_capacity(), Eq(8));
+}
+TEST(CircVectorCapacity, wrapsAcrossBoundary) {
+  CircVector<int> v(4);
+
+  v.push_back(2);
+  v.push_back(3);
+  v.push_front(1);
+  v.push_front(0);
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3]"));
+  v.pop_front();
+  v.push_back(4);
+  v.insert_after(0, 9);
+  EXPECT_THAT(v.to_string(), Eq("[1, 9, 2, 3, 4]"));
+  EXPECT_THAT(v.find(4), Eq(4));
+}
+TEST(CircVectorCapacity, exactCapacityMode) {
+  CircVector<int, false> v(3);
+  EXPECT_THAT(v.get_capacity(), Eq(3));
+
+  v.push_back(1);
+  v.push_back(2);
+  v.push_front(0);
+  v.push_front(-1);
+  EXPECT_THAT(v.get_capacity(), Eq(6));
+  EXPECT_THAT(v.to_string(), Eq("[-1, 0, 1, 2]"));
+}
+TEST(CircVectorCapacity, rejectsHugeCapacity) {
+  // Rounding these up to a power of two would overflow.
+  EXPECT_THROW(CircVector<int>(SIZE_MAX / 2 + 2), length_error);
+  EXPECT_THROW(CircVector<int>(SIZE_MAX), length_error);
+  EXPECT_THROW(CircVector<int>(CircVector<int>::max_size() + 1),
+               length_error);
+  EXPECT_THROW((CircVector<int, false>(SIZE_MAX / 2)), length_error);
+  EXPECT_THAT(CircVector<int>::max_size(), Eq(size_t(1) << 61));
+  EXPECT_THAT((CircVector<char, false>::max_size()), Eq(SIZE_MAX));
+}
+
+//Move
+TEST(CircVectorMove, moveOnlyElements) {
+  CircVector<unique_ptr<int>> v(2);
+
+  v.push_back(make_unique<int>(2));
+  v.push_front(make_unique<int>(1));
+  v.emplace_back(new int(4));
+  v.emplace_after(1, new int(3));
+
+  EXPECT_THAT(v.size(), Eq(4));
+  EXPECT_THAT(*v.at(2), Eq(3));
+  unique_ptr<int> front = v.pop_front();
+  unique_ptr<int> back = v.pop_back();
+  EXPECT_THAT(*front, Eq(1));
+  EXPECT_THAT(*back, Eq(4));
+}
+TEST(CircVectorMove, emplaceReturnsElement) {
+  CircVector<string> v;
+
+  string &s = v.emplace_back(3, 'x');
+  EXPECT_THAT(s, Eq("xxx"));
+  v.emplace_front("a");
+  EXPECT_THAT(v.to_string(), Eq("[a, xxx]"));
+}
+TEST(CircVectorMove, moveConstructAndAssign) {
+  CircVector<string> v1;
+  v1.push_back("a");
+  v1.push_back("b");
+  string *buffer = v1.get_data();
+
+  CircVector<string> v2(std::move(v1));
+  EXPECT_THAT(v2.get_data(), Eq(buffer));
+  EXPECT_THAT(v2.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(v1.empty(), Eq(true));
+
+  v1.push_back("c");
+  EXPECT_THAT(v1.to_string(), Eq("[c]"));
+
+  v1 = std::move(v2);
+  EXPECT_THAT(v1.get_data(), Eq(buffer));
+  EXPECT_THAT(v1.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(v2.size(), Eq(0));
+}
+TEST(CircVectorMove, pushMovesValue) {
+  CircVector<string> v;
+  string s(100, 'z');
+
+  v.push_back(std::move(s));
+  EXPECT_THAT(v.at(0).size(), Eq(100));
+  EXPECT_THAT(v.pop_back().size(), Eq(100));
+}
+
+//Storage
+namespace {
+
+struct Tracked {
+  static int live;
+  int value;
+
+  Tracked(int value) : value(value) {
+    live++;
+  }
+  Tracked(const Tracked &other) : value(other.value) {
+    live++;
+  }
+  Tracked &operator=(const Tracked &other) = default;
+  ~Tracked() {
+    live--;
+  }
+};
+int Tracked::live = 0;
+
+// Copies succeed until `copies_left` runs out, then throw.
+struct FailingCopy : Tracked {
+  static int copies_left;
+
+  FailingCopy(int value) : Tracked(value) {
+  }
+  FailingCopy(const FailingCopy &other) : Tracked(check(other)) {
+  }
+  FailingCopy &operator=(const FailingCopy &other) = default;
+
+  static const Tracked &check(const FailingCopy &other) {
+    if (copies_left-- == 0) {
+      throw runtime_error("copy failed");
+    }
+    return other;
+  }
+};
+int FailingCopy::copies_left = 0;
+
+}  // namespace
+
+TEST(CircVectorStorage, noDefaultConstruction) {
+  Tracked::live = 0;
+  {
+    CircVector<Tracked> v;
+    EXPECT_THAT(Tracked::live, Eq(0));
+
+    v.emplace_back(1);
+    v.emplace_front(0);
+    EXPECT_THAT(Tracked::live, Eq(2));
+    EXPECT_THAT(v.at(1).value, Eq(1));
+  }
+  EXPECT_THAT(Tracked::live, Eq(0));
+}
+TEST(CircVectorStorage, failedCopyDestroysPartialCopy) {
+  Tracked::live = 0;
+  {
+    CircVector<FailingCopy> v(8);
+    for (int i = 0; i < 5; i++) {
+      v.emplace_back(i);
+    }
+    FailingCopy::copies_left = 3;
+    EXPECT_THROW(CircVector<FailingCopy> copy(v), runtime_error);
+    EXPECT_THAT(Tracked::live, Eq(5));
+
+    // Assignment keeps what was copied, and the destructor frees it.
+    CircVector<FailingCopy> target;
+    target.emplace_back(9);
+    FailingCopy::copies_left = 2;
+    EXPECT_THROW(target = v, runtime_error);
+    EXPECT_THAT(target.size(), Eq(2));
+    EXPECT_THAT(Tracked::live, Eq(7));
+  }
+  EXPECT_THAT(Tracked::live, Eq(0));
+}
+TEST(CircVectorStorage, popAndClearDestroy) {
+  Tracked::live = 0;
+  CircVector<Tracked> v(2);
+
+  for (int i = 0; i < 6; i++) {
+    v.emplace_back(i);
+  }
+  EXPECT_THAT(Tracked::live, Eq(6));
+  v.pop_front();
+  v.pop_back();
+  EXPECT_THAT(Tracked::live, Eq(4));
+  v.remove_at(1);
+  EXPECT_THAT(Tracked::live, Eq(3));
+  v.insert_after(0, Tracked(7));
+  EXPECT_THAT(Tracked::live, Eq(4));
+  v.remove_evens();
+  EXPECT_THAT(Tracked::live, Eq(2));
+  EXPECT_THAT(v.at(0).value, Eq(7));
+  EXPECT_THAT(v.at(1).value, Eq(4));
+
+  CircVector<Tracked> copy(v);
+  EXPECT_THAT(Tracked::live, Eq(4));
+  copy = v;
+  EXPECT_THAT(Tracked::live, Eq(4));
+
+  v.clear();
+  copy.clear();
+  EXPECT_THAT(Tracked::live, Eq(0));
+}
+TEST(CircVectorStorage, pushOwnElementWhileFull) {
+  CircVector<string> v(2);
+  v.push_back("a");
+  v.push_back("b");
+
+  v.push_back(v.at(0));
+  v.push_front(v.at(2));
+  v.insert_after(1, v.at(3));
+
+  EXPECT_THAT(v.to_string(), Eq("[a, a, a, b, a]"));
+}
+
+//Spans
+TEST(CircVectorSpans, contiguousContents) {
+  CircVector<int> v;
+  v.push_back(1);
+  v.push_back(2);
+
+  auto [first, second] = v.as_spans();
+  EXPECT_THAT(first, ElementsAre(1, 2));
+  EXPECT_THAT(second.empty(), Eq(true));
+}
+TEST(CircVectorSpans, wrappedContents) {
+  CircVector<int> v(4);
+  v.push_back(2);
+  v.push_back(3);
+  v.push_front(1);
+  v.push_front(0);
+
+  auto [first, second] = v.as_spans();
+  EXPECT_THAT(first, ElementsAre(0, 1));
+  EXPECT_THAT(second, ElementsAre(2, 3));
+  EXPECT_THAT(second.data(), Eq(v.get_data()));
+
+  first[0] = 5;
+  EXPECT_THAT(v.at(0), Eq(5));
+}
+TEST(CircVectorSpans, constAndEmpty) {
+  const CircVector<int> empty;
+  auto [first, second] = empty.as_spans();
+  EXPECT_THAT(first.size() + second.size(), Eq(0));
+
+  CircVector<int> v(2);
+  v.push_front(1);
+  const CircVector<int> &ref = v;
+  auto [cfirst, csecond] = ref.as_spans();
+  EXPECT_THAT(cfirst, ElementsAre(1));
+  EXPECT_THAT(csecond.empty(), Eq(true));
+}
+
+//Iterators
+TEST(CircVectorIterators, rangeForAcrossWrap) {
+  CircVector<int> v(4);
+  v.push_back(2);
+  v.push_back(3);
+  v.push_front(1);
+  v.push_front(0);
+
+  vector<int> seen;
+  for (int x : v) {
+    seen.push_back(x);
+  }
+  EXPECT_THAT(seen, ElementsAre(0, 1, 2, 3));
+
+  for (int &x : v) {
+    x *= 10;
+  }
+  EXPECT_THAT(v.to_string(), Eq("[0, 10, 20, 30]"));
+}
+TEST(CircVectorIterators, randomAccess) {
+  CircVector<int> v(8);
+  for (int i = 0; i < 5; i++) {
+    v.push_back(i);
+  }
+  for (int i = 0; i < 3; i++) {
+    v.pop_front();
+    v.push_back(i + 5);
+  }
+
+  auto it = v.begin();
+  EXPECT_THAT(v.end() - it, Eq(5));
+  EXPECT_THAT(it[4], Eq(7));
+  EXPECT_THAT(*(it + 3), Eq(6));
+  EXPECT_THAT(*(v.end() - 1), Eq(7));
+  it += 4;
+  it -= 2;
+  EXPECT_THAT(*it, Eq(5));
+  EXPECT_THAT(it > v.begin(), Eq(true));
+  --it;
+  EXPECT_THAT(*it--, Eq(4));
+  EXPECT_THAT(*it, Eq(3));
+}
+TEST(CircVectorIterators, algorithms) {
+  CircVector<int> v(4);
+  v.push_back(3);
+  v.push_back(1);
+  v.push_front(4);
+  v.push_front(2);
+
+  static_assert(random_access_iterator<CircVector<int>::iterator>);
+  static_assert(random_access_iterator<CircVector<int>::const_iterator>);
+
+  sort(v.begin(), v.end());
+  EXPECT_THAT(v.to_string(), Eq("[1, 2, 3, 4]"));
+  EXPECT_THAT(*find(v.cbegin(), v.cend(), 3), Eq(3));
+  EXPECT_THAT(accumulate(v.cbegin(), v.cend(), 0), Eq(10));
+  EXPECT_THAT(*lower_bound(v.begin(), v.end(), 2), Eq(2));
+
+  CircVector<int>::const_iterator cit = v.begin();
+  EXPECT_THAT(cit == v.cbegin(), Eq(true));
+}
+TEST(CircVectorIterators, emptyAndFull) {
+  CircVector<int> empty;
+  EXPECT_THAT(empty.begin() == empty.end(), Eq(true));
+
+  CircVector<int> moved;
+  CircVector<int> taken(std::move(moved));
+  EXPECT_THAT(moved.begin() == moved.end(), Eq(true));
+
+  CircVector<int> full(2);
+  full.push_back(1);
+  full.push_back(2);
+  EXPECT_THAT(distance(full.begin(), full.end()), Eq(2));
+}
+
+//Bulk
+TEST(CircVectorBulk, appendWrapsIntoTwoRuns) {
+  CircVector<int> v(8);
+  v.push_back(1);
+  v.push_front(0);
+  vector<int> batch = {2, 3, 4, 5};
+
+  v.append(batch);
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3, 4, 5]"));
+  EXPECT_THAT(v.get_capacity(), Eq(8));
+  auto [first, second] = v.as_spans();
+  EXPECT_THAT(first, ElementsAre(0));
+  EXPECT_THAT(second, ElementsAre(1, 2, 3, 4, 5));
+}
+TEST(CircVectorBulk, appendReallocatesOnce) {
+  CircVector<int> v(4);
+  v.push_back(0);
+  v.push_front(-1);
+  vector<int> batch(100);
+  iota(batch.begin(), batch.end(), 1);
+
+  v.append(batch);
+  EXPECT_THAT(v.get_capacity(), Eq(128));
+  EXPECT_THAT(v.size(), Eq(102));
+  EXPECT_THAT(v.at(0), Eq(-1));
+  EXPECT_THAT(v.at(101), Eq(100));
+
+  // Small appends still grow geometrically.
+  CircVector<int> w(4);
+  w.append(vector<int>{1, 2, 3, 4, 5});
+  EXPECT_THAT(w.get_capacity(), Eq(8));
+}
+TEST(CircVectorBulk, appendOtherSources) {
+  CircVector<string> v(2);
+  v.push_back("a");
+  v.append(list<string>{"b", "c"});
+  v.append(vector<const char *>{"d"});
+  EXPECT_THAT(v.to_string(), Eq("[a, b, c, d]"));
+
+  CircVector<int> wrapped(4);
+  wrapped.push_back(3);
+  wrapped.push_front(2);
+  wrapped.push_front(1);
+  CircVector<int> w;
+  w.append(wrapped);
+  w.append(views::iota(4, 6));
+  EXPECT_THAT(w.to_string(), Eq("[1, 2, 3, 4, 5]"));
+
+  // Unsized input range: falls back to one push per element.
+  istringstream in("6 7 8");
+  w.append(views::istream<int>(in));
+  EXPECT_THAT(w.to_string(), Eq("[1, 2, 3, 4, 5, 6, 7, 8]"));
+}
+TEST(CircVectorBulk, assignAndRangeConstructor) {
+  CircVector<int> v(4);
+  v.push_front(9);
+  v.assign(vector<int>{1, 2, 3});
+  EXPECT_THAT(v.to_string(), Eq("[1, 2, 3]"));
+  EXPECT_THAT(v.get_capacity(), Eq(4));
+
+  v.assign(views::iota(0, 20));
+  EXPECT_THAT(v.size(), Eq(20));
+  EXPECT_THAT(v.get_capacity(), Eq(32));
+  EXPECT_THAT(v.at(19), Eq(19));
+
+  CircVector<int> built(vector<int>{5, 6, 7});
+  EXPECT_THAT(built.to_string(), Eq("[5, 6, 7]"));
+  EXPECT_THAT(built.get_capacity(), Eq(4));
+
+  CircVector<int, false> exact(views::iota(0, 5));
+  EXPECT_THAT(exact.get_capacity(), Eq(5));
+  exact.push_back(5);
+  EXPECT_THAT(exact.to_string(), Eq("[0, 1, 2, 3, 4, 5]"));
+}
+TEST(CircVectorBulk, reserve) {
+  CircVector<string> v(4);
+  v.push_back("b");
+  v.push_front("a");
+  string *before = v.get_data();
+
+  v.reserve(3);
+  EXPECT_THAT(v.get_data(), Eq(before));
+  v.reserve(5);
+  EXPECT_THAT(v.get_capacity(), Eq(8));
+  EXPECT_THAT(v.to_string(), Eq("[a, b]"));
+
+  Tracked::live = 0;
+  {
+    CircVector<Tracked> t(2);
+    t.emplace_back(1);
+    t.emplace_front(0);
+    t.reserve(16);
+    t.append(vector<Tracked>{Tracked(2)});
+    EXPECT_THAT(Tracked::live, Eq(3));
+    EXPECT_THAT(t.at(2).value, Eq(2));
+  }
+  EXPECT_THAT(Tracked::live, Eq(0));
+}
+TEST(CircVectorBulk, rejectsHugeSizes) {
+  CircVector<int> v;
+  for (int i = 0; i < 5; i++) {
+    v.push_back(i);
+  }
+  int *before = v.get_data();
+  EXPECT_THROW(v.reserve(SIZE_MAX / 2 + 2), length_error);
+  EXPECT_THROW(v.reserve(SIZE_MAX), length_error);
+  EXPECT_THAT(v.get_data(), Eq(before));
+  EXPECT_THAT(v.get_capacity(), Eq(16));
+
+  // Sizes that would wrap `size() + n` around.
+  EXPECT_THROW(v.append(views::iota(size_t(0), SIZE_MAX - 2)), length_error);
+  EXPECT_THROW(CircVector<int>(views::iota(size_t(0), size_t(1) << 62)),
+               length_error);
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3, 4]"));
+}
+
+//Scan
+TEST(CircVectorScan, acrossBothSegments) {
+  CircVector<int32_t> v(64);
+  for (int i = 0; i < 40; i++) {
+    v.push_back(i % 10);
+  }
+  for (int i = 0; i < 20; i++) {
+    v.push_front(i % 10);
+  }
+  // Front 20 elements sit at the end of the buffer, the rest wrap to 0.
+  EXPECT_THAT(v.as_spans().second.size(), Eq(40));
+
+  // [9, 8, ..., 0, 9, 8, ..., 0, 0, 1, ..., 9, 0, 1, ..., 9, ...]
+  EXPECT_THAT(v.find(9), Eq(0));
+  EXPECT_THAT(v.find(0), Eq(9));
+  EXPECT_THAT(v.find_last(9), Eq(59));
+  EXPECT_THAT(v.find_last(0), Eq(50));
+  EXPECT_THAT(v.count(3), Eq(6));
+  EXPECT_THAT(v.contains(7), Eq(true));
+  EXPECT_THAT(v.contains(10), Eq(false));
+  EXPECT_THAT(v.find(10), Eq(size_t(-1)));
+  EXPECT_THAT(v.find_last(10), Eq(size_t(-1)));
+}
+TEST(CircVectorScan, wideAndFloatingKeys) {
+  CircVector<uint64_t> ids(8);
+  for (uint64_t i = 0; i < 6; i++) {
+    ids.push_back(i << 40);
+  }
+  ids.pop_front();
+  ids.pop_front();
+  ids.push_back(uint64_t(3) << 40);
+  ids.push_back(uint64_t(7) << 40);
+  ids.push_back(3);
+  EXPECT_THAT(ids.find(uint64_t(3) << 40), Eq(1));
+  EXPECT_THAT(ids.find_last(uint64_t(3) << 40), Eq(4));
+  EXPECT_THAT(ids.count(uint64_t(3) << 40), Eq(2));
+
+  CircVector<double> d;
+  d.push_back(0.5);
+  d.push_front(-0.0);
+  EXPECT_THAT(d.find(0.0), Eq(0));
+}
+TEST(CircVectorScan, nonArithmeticAndEmpty) {
+  CircVector<string> v(4);
+  v.push_back("b");
+  v.push_back("a");
+  v.push_front("a");
+  EXPECT_THAT(v.find("a"), Eq(0));
+  EXPECT_THAT(v.find_last("a"), Eq(2));
+  EXPECT_THAT(v.count("a"), Eq(2));
+  EXPECT_THAT(v.contains("c"), Eq(false));
+
+  CircVector<int> empty;
+  CircVector<int> moved(std::move(empty));
+  EXPECT_THAT(empty.find(1), Eq(size_t(-1)));
+  EXPECT_THAT(empty.count(1), Eq(0));
+  EXPECT_THAT(moved.contains(1), Eq(false));
+}
+
+//Growth
+TEST(CircVectorGrowth, policies) {
+  CircVector<int, false> half(4);
+  GrowthPolicy policy;
+  policy.kind = GrowthPolicy::OneAndHalf;
+  half.set_growth_policy(policy);
+  for (int i = 0; i < 7; i++) {
+    half.push_back(i);
+  }
+  EXPECT_THAT(half.get_capacity(), Eq(9));
+
+  CircVector<int, false> fixed(4);
+  policy.kind = GrowthPolicy::FixedIncrement;
+  policy.increment = 3;
+  fixed.set_growth_policy(policy);
+  for (int i = 0; i < 8; i++) {
+    fixed.push_front(i);
+  }
+  EXPECT_THAT(fixed.get_capacity(), Eq(10));
+  EXPECT_THAT(fixed.to_string(), Eq("[7, 6, 5, 4, 3, 2, 1, 0]"));
+
+  // 2002 slots of 4 bytes round up to two whole pages, 2048 slots.
+  CircVector<int32_t, false> paged(1001);
+  policy.kind = GrowthPolicy::PageRounded;
+  paged.set_growth_policy(policy);
+  for (int i = 0; i < 1002; i++) {
+    paged.push_back(i);
+  }
+  EXPECT_THAT(paged.get_capacity(), Eq(2048));
+
+  // Power-of-two mode still rounds whatever the policy asks for.
+  CircVector<int> pow2(8);
+  policy.kind = GrowthPolicy::FixedIncrement;
+  policy.increment = 20;
+  pow2.set_growth_policy(policy);
+  for (int i = 0; i < 9; i++) {
+    pow2.push_back(i);
+  }
+  EXPECT_THAT(pow2.get_capacity(), Eq(32));
+  CircVector<int> copy(pow2);
+  EXPECT_THAT(copy.get_growth_policy().increment, Eq(20));
+}
+TEST(CircVectorGrowth, shrinkToFit) {
+  CircVector<string, false> v(100);
+  v.push_back("b");
+  v.push_back("c");
+  v.push_front("a");
+  v.shrink_to_fit();
+  EXPECT_THAT(v.get_capacity(), Eq(3));
+  EXPECT_THAT(v.to_string(), Eq("[a, b, c]"));
+  v.push_back("d");
+  EXPECT_THAT(v.get_capacity(), Eq(6));
+
+  CircVector<int> p(64);
+  for (int i = 0; i < 5; i++) {
+    p.push_back(i);
+  }
+  p.shrink_to_fit();
+  EXPECT_THAT(p.get_capacity(), Eq(8));
+  p.clear();
+  p.shrink_to_fit();
+  EXPECT_THAT(p.get_capacity(), Eq(1));
+  p.push_back(7);
+  EXPECT_THAT(p.at(0), Eq(7));
+}
+TEST(CircVectorGrowth, autoShrink) {
+  CircVector<int> v;
+  GrowthPolicy policy;
+  policy.shrink_divisor = 4;
+  v.set_growth_policy(policy);
+  for (int i = 0; i < 1000; i++) {
+    v.push_back(i);
+  }
+  EXPECT_THAT(v.get_capacity(), Eq(1024));
+
+  // Nothing happens until the size drops to a quarter of the capacity.
+  while (v.size() > 257) {
+    v.pop_front();
+  }
+  EXPECT_THAT(v.get_capacity(), Eq(1024));
+  v.pop_back();
+  EXPECT_THAT(v.get_capacity(), Eq(512));
+  EXPECT_THAT(v.at(0), Eq(743));
+  EXPECT_THAT(v.at(255), Eq(998));
+
+  v.clear();
+  EXPECT_THAT(v.get_capacity(), Eq(16));
+
+  EXPECT_THROW(v.set_growth_policy({GrowthPolicy::Double, 1, 2}),
+               invalid_argument);
+  CircVector<int> plain;
+  for (int i = 0; i < 100; i++) {
+    plain.push_back(i);
+  }
+  plain.clear();
+  EXPECT_THAT(plain.get_capacity(), Eq(128));
+}
+
+//Format
+TEST(CircVectorFormat, matchesStreamOutput) {
+  auto streamed = [](const auto &c) {
+    stringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < c.size(); i++) {
+      ss << c.at(i) << (i + 1 < c.size() ? ", " : "");
+    }
+    ss << "]";
+    return ss.str();
+  };
+
+  CircVector<int64_t> ints(4);
+  for (int64_t x : {0L, -1L, 42L, INT64_MAX, INT64_MIN}) {
+    ints.push_front(x);
+  }
+  EXPECT_THAT(ints.to_string(), Eq(streamed(ints)));
+
+  CircVector<double> doubles;
+  for (double x : {0.0, -0.0, 1.5, 1e-5, 0.0001, 123456.0, 1234567.0,
+                   1.0 / 3, 1e300, -2.5e-300}) {
+    doubles.push_back(x);
+  }
+  doubles.push_back(numeric_limits<double>::infinity());
+  doubles.push_back(numeric_limits<double>::quiet_NaN());
+  EXPECT_THAT(doubles.to_string(), Eq(streamed(doubles)));
+
+  CircVector<float> floats;
+  floats.push_back(3.14159265f);
+  floats.push_back(-1e20f);
+  EXPECT_THAT(floats.to_string(), Eq(streamed(floats)));
+
+  CircVector<char> chars;
+  chars.push_back('a');
+  chars.push_back('b');
+  CircVector<bool> bools;
+  bools.push_back(true);
+  bools.push_back(false);
+  CircVector<string> words;
+  words.push_back("x");
+  words.push_back("");
+  words.push_back(string(5000, 'y'));
+  EXPECT_THAT(chars.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(bools.to_string(), Eq("[1, 0]"));
+  EXPECT_THAT(words.to_string(), Eq(streamed(words)));
+  EXPECT_THAT(CircVector<int>().to_string(), Eq("[]"));
+}
+TEST(CircVectorFormat, writeToStreamAndString) {
+  // Long enough to flush the formatting buffer many times.
+  CircVector<int> v(8);
+  for (int i = 0; i < 20000; i++) {
+    v.push_front(i * 7 - 5000);
+  }
+  string expected = v.to_string();
+
+  ostringstream os;
+  os << hex << setprecision(2);
+  v.write_to(os);
+  EXPECT_THAT(os.str(), Eq(expected));
+
+  string out = "v=";
+  v.write_to(out);
+  EXPECT_THAT(out, Eq("v=" + expected));
+}
+
+//Allocators
+namespace {
+
+// Forwards to the default resource and counts what passes through.
+class CountingResource : public pmr::memory_resource {
+ public:
+  size_t allocations = 0;
+  size_t live_bytes = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    allocations++;
+    live_bytes += bytes;
+    return pmr::get_default_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t align) override {
+    live_bytes -= bytes;
+    pmr::get_default_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(const pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+struct alignas(32) Record {
+  int64_t key;
+  int64_t payload[3];
+};
+
+}  // namespace
+
+TEST(CircVectorAlloc, pmrResourceGetsAllocations) {
+  CountingResource resource;
+  {
+    PmrCircVector<int> v(4, &resource);
+    EXPECT_THAT(v.get_allocator().resource(), Eq(&resource));
+    EXPECT_THAT(resource.allocations, Eq(1));
+    for (int i = 0; i < 100; i++) {
+      v.push_back(i);
+    }
+    EXPECT_THAT(resource.allocations, Gt(1));
+    EXPECT_THAT(resource.live_bytes, Eq(v.get_capacity() * sizeof(int)));
+    EXPECT_THAT(v.at(99), Eq(99));
+  }
+  EXPECT_THAT(resource.live_bytes, Eq(0));
+
+  // An arena: nothing is freed until the arena goes away.
+  char arena[1024];
+  pmr::monotonic_buffer_resource pool(arena, sizeof(arena),
+                                      pmr::null_memory_resource());
+  PmrCircVector<int> small(&pool);
+  small.push_back(1);
+  small.push_front(0);
+  EXPECT_THAT(small.to_string(), Eq("[0, 1]"));
+  EXPECT_THAT(static_cast<void *>(small.get_data()),
+              Ge(static_cast<void *>(arena)));
+  EXPECT_THAT(static_cast<void *>(small.get_data()),
+              Lt(static_cast<void *>(arena + sizeof(arena))));
+}
+TEST(CircVectorAlloc, elementsUseTheResource) {
+  CountingResource resource;
+  PmrCircVector<pmr::string> words(2, &resource);
+  words.push_back(pmr::string(100, 'a'));
+  words.emplace_back(200, 'b');
+  words.push_front("a string too long for the small-string buffer");
+  EXPECT_THAT(words.at(0).get_allocator().resource(), Eq(&resource));
+  EXPECT_THAT(words.at(1).get_allocator().resource(), Eq(&resource));
+  EXPECT_THAT(words.at(2).get_allocator().resource(), Eq(&resource));
+  // Buffer plus one block per long string.
+  EXPECT_THAT(resource.allocations, Ge(4));
+}
+TEST(CircVectorAlloc, copyAndMoveAcrossResources) {
+  CountingResource first;
+  CountingResource second;
+  PmrCircVector<pmr::string> a(&first);
+  for (int i = 0; i < 20; i++) {
+    a.push_back(pmr::string(50, 'a' + i));
+  }
+
+  // Copies do not propagate a polymorphic allocator.
+  PmrCircVector<pmr::string> copy(a);
+  EXPECT_THAT(copy.get_allocator().resource(),
+              Eq(pmr::get_default_resource()));
+  EXPECT_THAT(copy.to_string(), Eq(a.to_string()));
+
+  // Same resource: the buffer is taken over.
+  PmrCircVector<pmr::string> same(&first);
+  const pmr::string *buffer = a.get_data();
+  same = std::move(a);
+  EXPECT_THAT(same.get_data(), Eq(buffer));
+  EXPECT_THAT(a.size(), Eq(0));
+
+  // Different resource: the elements are moved into a buffer of its own.
+  PmrCircVector<pmr::string> other(&second);
+  size_t before = second.allocations;
+  other = std::move(same);
+  EXPECT_THAT(other.get_allocator().resource(), Eq(&second));
+  EXPECT_THAT(other.size(), Eq(20));
+  EXPECT_THAT(other.at(19), Eq(pmr::string(50, 'a' + 19)));
+  EXPECT_THAT(other.at(0).get_allocator().resource(), Eq(&second));
+  EXPECT_THAT(second.allocations, Gt(before));
+  EXPECT_THAT(same.size(), Eq(0));
+}
+TEST(CircVectorAlloc, failedAssignmentAllocationLeavesEmpty) {
+  PmrCircVector<int> source;
+  for (int i = 0; i < 1000; i++) {
+    source.push_back(i);
+  }
+
+  // Too small for `source`'s buffer, with nowhere else to allocate from.
+  char arena[256];
+  pmr::monotonic_buffer_resource pool(arena, sizeof(arena),
+                                      pmr::null_memory_resource());
+  PmrCircVector<int> copied(&pool);
+  copied.push_back(1);
+  EXPECT_THROW(copied = source, bad_alloc);
+  EXPECT_THAT(copied.size(), Eq(0));
+  EXPECT_THAT(copied.get_capacity(), Eq(0));
+  EXPECT_THAT(copied.get_data(), IsNull());
+
+  PmrCircVector<int> moved(&pool);
+  EXPECT_THROW(moved = std::move(source), bad_alloc);
+  EXPECT_THAT(moved.size(), Eq(0));
+  EXPECT_THAT(moved.get_capacity(), Eq(0));
+  EXPECT_THAT(source.size(), Eq(1000));
+}
+TEST(CircVectorAlloc, alignedBuffer) {
+  AlignedCircVector<Record> records(3);
+  for (int64_t i = 0; i < 50; i++) {
+    records.push_back({i, {i, i, i}});
+    EXPECT_THAT(reinterpret_cast<uintptr_t>(records.get_data()) % 64, Eq(0));
+  }
+  EXPECT_THAT(records.at(49).key, Eq(49));
+
+  AlignedCircVector<char, false> bytes(5);
+  bytes.push_back('x');
+  EXPECT_THAT(reinterpret_cast<uintptr_t>(bytes.get_data()) % 64, Eq(0));
+  EXPECT_THAT(sizeof(AlignedCircVector<int>), Eq(sizeof(CircVector<int>)));
+}
+
+//Small buffer
+namespace {
+
+template <typename V>
+bool is_inline(const V &v) {
+  auto data = reinterpret_cast<uintptr_t>(v.get_data());
+  auto self = reinterpret_cast<uintptr_t>(&v);
+  return data >= self && data < self + sizeof(v);
+}
+
+}  // namespace
+
+TEST(CircVectorSmall, staysInlineUntilFull) {
+  SmallCircVector<int, 8> v;
+  EXPECT_THAT(is_inline(v), Eq(true));
+  EXPECT_THAT(v.get_capacity(), Eq(8));
+  for (int i = 0; i < 8; i++) {
+    v.push_front(i);
+  }
+  EXPECT_THAT(is_inline(v), Eq(true));
+  EXPECT_THAT(v.to_string(), Eq("[7, 6, 5, 4, 3, 2, 1, 0]"));
+
+  v.push_back(8);
+  EXPECT_THAT(is_inline(v), Eq(false));
+  EXPECT_THAT(v.get_capacity(), Eq(16));
+  EXPECT_THAT(v.to_string(), Eq("[7, 6, 5, 4, 3, 2, 1, 0, 8]"));
+
+  // Back under the inline size, `shrink_to_fit` returns to the inline buffer.
+  v.pop_front();
+  v.pop_front();
+  v.shrink_to_fit();
+  EXPECT_THAT(is_inline(v), Eq(true));
+  EXPECT_THAT(v.to_string(), Eq("[5, 4, 3, 2, 1, 0, 8]"));
+
+  // Capacities never drop below the inline buffer.
+  SmallCircVector<int, 6, false> exact(2);
+  EXPECT_THAT(exact.get_capacity(), Eq(6));
+  EXPECT_THAT(is_inline(exact), Eq(true));
+  SmallCircVector<int, 6> rounded;
+  EXPECT_THAT(rounded.get_capacity(), Eq(8));
+}
+TEST(CircVectorSmall, copyAndMove) {
+  SmallCircVector<string, 4> small;
+  small.push_back("short");
+  small.push_back(string(100, 'x'));
+  SmallCircVector<string, 4> copy(small);
+  EXPECT_THAT(is_inline(copy), Eq(true));
+  EXPECT_THAT(copy.to_string(), Eq(small.to_string()));
+
+  // Inline elements are moved over; the source stays inline and usable.
+  SmallCircVector<string, 4> moved(std::move(small));
+  EXPECT_THAT(is_inline(moved), Eq(true));
+  EXPECT_THAT(moved.at(1), Eq(string(100, 'x')));
+  EXPECT_THAT(small.size(), Eq(0));
+  EXPECT_THAT(is_inline(small), Eq(true));
+  small.push_back("again");
+  EXPECT_THAT(small.to_string(), Eq("[again]"));
+
+  // A heap buffer is taken over as is.
+  SmallCircVector<string, 4> big;
+  for (int i = 0; i < 10; i++) {
+    big.push_back(std::to_string(i));
+  }
+  const string *buffer = big.get_data();
+  copy = std::move(big);
+  EXPECT_THAT(copy.get_data(), Eq(buffer));
+  EXPECT_THAT(copy.size(), Eq(10));
+  EXPECT_THAT(is_inline(big), Eq(true));
+
+  moved = copy;
+  EXPECT_THAT(moved.to_string(), Eq(copy.to_string()));
+  copy = std::move(moved);
+  EXPECT_THAT(copy.at(9), Eq("9"));
+}
+TEST(CircVectorSmall, destroysInlineElements) {
+  Tracked::live = 0;
+  {
+    SmallCircVector<Tracked, 4> v;
+    v.push_back(Tracked(1));
+    v.push_back(Tracked(2));
+    SmallCircVector<Tracked, 4> w(std::move(v));
+    EXPECT_THAT(Tracked::live, Eq(2));
+    w.pop_front();
+    EXPECT_THAT(Tracked::live, Eq(1));
+  }
+  EXPECT_THAT(Tracked::live, Eq(0));
+}
+
+//Shorter-side shifting
+TEST(CircVectorShift, matchesDeque) {
+  auto check = [](auto v) {
+    deque<string> model;
+    for (int i = 0; i < 12; i++) {
+      v.push_front(std::to_string(i));
+      model.push_front(std::to_string(i));
+    }
+    // Edits at every position, both sides of the middle, across the wrap.
+    for (size_t round = 0; round < 40; round++) {
+      size_t index = (round * 7) % (model.size() + 1);
+      string value = "x" + std::to_string(round);
+      if (round % 3 == 2 && index < model.size()) {
+        v.remove_at(index);
+        model.erase(model.begin() + index);
+      }
+      else if (round % 3 == 1 && index < model.size()) {
+        v.insert_before(index, value);
+        model.insert(model.begin() + index, value);
+      }
+      else {
+        v.insert_at(index, value);
+        model.insert(model.begin() + index, value);
+      }
+      ASSERT_THAT(v.size(), Eq(model.size()));
+      for (size_t i = 0; i < model.size(); i++) {
+        ASSERT_THAT(v.at(i), Eq(model[i]));
+      }
+    }
+  };
+  check(CircVector<string>(16));
+  check(CircVector<string, false>(13));
+}
+TEST(CircVectorShift, movesTheShorterSide) {
+  CircVector<int> v(16);
+  for (int i = 0; i < 10; i++) {
+    v.push_back(i);
+  }
+
+  // Near the front only the elements before the index move, and the front
+  // wraps back to the end of the buffer.
+  v.insert_at(1, 100);
+  EXPECT_THAT(v.as_spans().first.size(), Eq(1));
+  EXPECT_THAT(v.as_spans().first[0], Eq(0));
+  EXPECT_THAT(v.get_data()[0], Eq(100));
+  v.remove_at(1);
+  EXPECT_THAT(v.as_spans().first.size(), Eq(10));
+  EXPECT_THAT(v.get_data()[0], Eq(0));
+
+  // Near the back the front stays put.
+  v.insert_before(8, 200);
+  v.remove_at(9);
+  EXPECT_THAT(v.get_data()[0], Eq(0));
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3, 4, 5, 6, 7, 200, 9]"));
+
+  v.remove_at(1);
+  EXPECT_THAT(v.get_data()[1], Eq(0));
+  EXPECT_THAT(v.to_string(), Eq("[0, 2, 3, 4, 5, 6, 7, 200, 9]"));
+}
+TEST(CircVectorShift, insertAtAndBeforeBounds) {
+  CircVector<int> v;
+  EXPECT_THROW(v.insert_before(0, 1), out_of_range);
+  v.insert_at(0, 2);
+  v.insert_at(1, 4);
+  v.insert_before(0, 1);
+  v.insert_before(2, 3);
+  EXPECT_THAT(v.emplace_before(0, 0), Eq(0));
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3, 4]"));
+  EXPECT_THROW(v.insert_at(6, 5), out_of_range);
+  EXPECT_THROW(v.insert_before(5, 5), out_of_range);
+
+  // The value may be an element of the vector itself.
+  v.insert_at(4, v.at(1));
+  v.insert_before(1, v.at(4));
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 1, 2, 3, 1, 4]"));
+}
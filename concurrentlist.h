@@ -0,0 +1,522 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Epoch-based memory reclamation, shared by every `ConcurrentList`.
+ *
+ * A thread pins the current global epoch (with `Guard`) for the duration of
+ * each operation. Nodes unlinked during an operation are `retire`d into a
+ * per-thread bucket for the global epoch at the time, and are only freed
+ * once the global epoch has moved two past it: the epoch can only advance
+ * when every pinned thread has caught up with it, so by then every thread
+ * that could have reached them has unpinned.
+ */
+class EpochDomain {
+ private:
+  struct Retired {
+    void *ptr;
+    void (*deleter)(void *);
+  };
+
+  static constexpr size_t cache_line = 64;
+  static constexpr int buckets = 3;
+  // Retirements between attempts to advance the epoch.
+  static constexpr size_t advance_interval = 64;
+
+  // One per thread; recycled once a thread exits. `state` is the pinned
+  // epoch shifted left by one, with the low bit set while pinned.
+  struct alignas(cache_line) Record {
+    atomic<uint64_t> state;
+    atomic<bool> in_use;
+    Record *next;
+    size_t nesting;
+    size_t retired_since_advance;
+    uint64_t bucket_epoch[buckets];
+    vector<Retired> limbo[buckets];
+  };
+
+  // Registers a thread's record on first use and releases it at thread exit.
+  struct Handle {
+    EpochDomain *domain;
+    Record *record;
+
+    ~Handle() {
+      if (record != nullptr) {
+        domain->release(record);
+      }
+    }
+  };
+
+  atomic<uint64_t> global_epoch;
+  atomic<Record *> records;
+  // Nodes left behind by exited threads, with the epoch they were retired in.
+  mutex orphan_lock;
+  vector<pair<uint64_t, Retired>> orphans;
+
+  EpochDomain() : global_epoch(0), records(nullptr) {
+  }
+
+  static void free_all(vector<Retired> &retired) {
+    for (Retired &r : retired) {
+      r.deleter(r.ptr);
+    }
+    retired.clear();
+  }
+
+  /**
+   * Returns the calling thread's record, claiming a free one (or adding a new
+   * one) the first time the thread uses the domain.
+   */
+  Record *local() {
+    thread_local Handle handle{this, nullptr};
+    if (handle.record != nullptr) {
+      return handle.record;
+    }
+    for (Record *r = records.load(memory_order_acquire); r != nullptr;
+         r = r->next) {
+      bool expected = false;
+      if (!r->in_use.load(memory_order_relaxed) &&
+          r->in_use.compare_exchange_strong(expected, true)) {
+        handle.record = r;
+        return r;
+      }
+    }
+    Record *r = new Record();
+    r->state.store(0, memory_order_relaxed);
+    r->in_use.store(true, memory_order_relaxed);
+    r->nesting = 0;
+    r->retired_since_advance = 0;
+    for (int b = 0; b < buckets; b++) {
+      r->bucket_epoch[b] = 0;
+    }
+    Record *head = records.load(memory_order_relaxed);
+    do {
+      r->next = head;
+    } while (!records.compare_exchange_weak(head, r, memory_order_release,
+                                            memory_order_relaxed));
+    handle.record = r;
+    return r;
+  }
+
+  /**
+   * Hands a thread's unfreed retirements over to the orphan list and frees
+   * its record for reuse.
+   */
+  void release(Record *r) {
+    {
+      lock_guard<mutex> guard(orphan_lock);
+      for (int b = 0; b < buckets; b++) {
+        for (Retired &retired : r->limbo[b]) {
+          orphans.emplace_back(r->bucket_epoch[b], retired);
+        }
+        r->limbo[b].clear();
+      }
+    }
+    r->state.store(0, memory_order_release);
+    r->in_use.store(false, memory_order_release);
+  }
+
+  /**
+   * Advances the global epoch if every pinned thread has reached it.
+   */
+  void try_advance() {
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t epoch = global_epoch.load(memory_order_relaxed);
+    for (Record *r = records.load(memory_order_acquire); r != nullptr;
+         r = r->next) {
+      uint64_t state = r->state.load(memory_order_relaxed);
+      if ((state & 1) != 0 && (state >> 1) != epoch) {
+        return;
+      }
+    }
+    atomic_thread_fence(memory_order_acquire);
+    global_epoch.compare_exchange_strong(epoch, epoch + 1,
+                                         memory_order_release);
+  }
+
+  /**
+   * Frees the calling thread's buckets, and any orphans, that are at least
+   * two epochs old.
+   */
+  void collect(Record *r) {
+    uint64_t epoch = global_epoch.load(memory_order_acquire);
+    for (int b = 0; b < buckets; b++) {
+      if (r->bucket_epoch[b] + 2 <= epoch) {
+        free_all(r->limbo[b]);
+      }
+    }
+    unique_lock<mutex> guard(orphan_lock, try_to_lock);
+    if (guard.owns_lock() && !orphans.empty()) {
+      size_t kept = 0;
+      for (auto &[retired_epoch, retired] : orphans) {
+        if (retired_epoch + 2 <= epoch) {
+          retired.deleter(retired.ptr);
+        }
+        else {
+          orphans[kept++] = {retired_epoch, retired};
+        }
+      }
+      orphans.resize(kept);
+    }
+  }
+
+ public:
+  /**
+   * Pins the calling thread to the current epoch for its lifetime. Guards
+   * nest; only the outermost one pins and unpins.
+   */
+  class Guard {
+   private:
+    Record *record;
+
+   public:
+    explicit Guard(EpochDomain &domain) : record(domain.local()) {
+      if (record->nesting++ == 0) {
+        uint64_t epoch = domain.global_epoch.load(memory_order_relaxed);
+        for (;;) {
+          record->state.store((epoch << 1) | 1, memory_order_relaxed);
+          // The pin must be visible before this thread reads any node.
+          atomic_thread_fence(memory_order_seq_cst);
+          // If the epoch moved before the pin was visible, other threads
+          // may have advanced it without waiting for this one. Re-pin, so
+          // the global epoch stays within one of the pinned epoch.
+          uint64_t now = domain.global_epoch.load(memory_order_relaxed);
+          if (now == epoch) {
+            break;
+          }
+          epoch = now;
+        }
+      }
+    }
+
+    ~Guard() {
+      if (--record->nesting == 0) {
+        record->state.store(0, memory_order_release);
+      }
+    }
+
+    Guard(const Guard &other) = delete;
+    Guard &operator=(const Guard &other) = delete;
+  };
+
+  EpochDomain(const EpochDomain &other) = delete;
+  EpochDomain &operator=(const EpochDomain &other) = delete;
+
+  /**
+   * Destructor. Runs at program exit, after every thread's record has been
+   * released, and frees whatever is still waiting.
+   */
+  ~EpochDomain() {
+    for (auto &[retired_epoch, retired] : orphans) {
+      retired.deleter(retired.ptr);
+    }
+    Record *r = records.load(memory_order_acquire);
+    while (r != nullptr) {
+      Record *next = r->next;
+      for (int b = 0; b < buckets; b++) {
+        free_all(r->limbo[b]);
+      }
+      delete r;
+      r = next;
+    }
+  }
+
+  /**
+   * Returns the process-wide domain.
+   */
+  static EpochDomain &instance() {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  /**
+   * Schedules `ptr` to be passed to `deleter` once no thread can still be
+   * reading it. Must be called while the calling thread holds a `Guard`, and
+   * after `ptr` has been made unreachable.
+   */
+  void retire(void *ptr, void (*deleter)(void *)) {
+    Record *r = local();
+    // Tag with the global epoch as of now, after the unlink: any thread that
+    // could still have reached `ptr` is pinned at this epoch or earlier.
+    uint64_t epoch = global_epoch.load(memory_order_seq_cst);
+    int b = epoch % buckets;
+    if (r->bucket_epoch[b] != epoch) {
+      // Whatever is there is from at least three epochs ago.
+      free_all(r->limbo[b]);
+      r->bucket_epoch[b] = epoch;
+    }
+    r->limbo[b].push_back({ptr, deleter});
+    if (++r->retired_since_advance >= advance_interval) {
+      r->retired_since_advance = 0;
+      try_advance();
+      collect(r);
+    }
+  }
+};
+
+/**
+ * Sorted, duplicate-free linked list that many threads can search and
+ * modify concurrently, for shared membership sets.
+ *
+ * Removal follows Harris: the low bit of a node's `next` pointer marks the
+ * node as logically deleted, after which no thread can link anything after
+ * it, and any thread that walks past it helps unlink it (Michael's variant).
+ * Unlinked nodes are reclaimed through `EpochDomain`.
+ *
+ * `contains` never writes and never retries, so it is wait-free; `insert`
+ * and `remove` are lock-free. Copying and the destructor are not
+ * thread-safe.
+ */
+template <typename T, typename Compare = less<T>>
+class ConcurrentList {
+ private:
+  struct Node {
+    T data;
+    atomic<uintptr_t> next;
+
+    template <typename... Args>
+    explicit Node(Args &&...args) : data(std::forward<Args>(args)...), next(0) {
+    }
+  };
+
+  static constexpr uintptr_t mark_bit = 1;
+
+  atomic<uintptr_t> head;
+  atomic<size_t> list_size;
+  [[no_unique_address]] Compare comp;
+
+  static Node *to_node(uintptr_t link) {
+    return reinterpret_cast<Node *>(link & ~mark_bit);
+  }
+
+  static bool is_marked(uintptr_t link) {
+    return (link & mark_bit) != 0;
+  }
+
+  static void delete_node(void *node) {
+    delete static_cast<Node *>(node);
+  }
+
+  /**
+   * Finds the first node not less than `key`, unlinking any marked nodes on
+   * the way. On return, `prev` is the link that pointed to `curr` (which may
+   * be null) when both were last seen unmarked. Returns whether `curr` holds
+   * `key`. The caller must hold an `EpochDomain::Guard`.
+   */
+  bool search(const T &key, atomic<uintptr_t> *&prev, Node *&curr) {
+  retry:
+    prev = &head;
+    curr = to_node(prev->load(memory_order_acquire));
+    while (curr != nullptr) {
+      uintptr_t next = curr->next.load(memory_order_acquire);
+      if (is_marked(next)) {
+        uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+        if (!prev->compare_exchange_strong(expected, next & ~mark_bit,
+                                           memory_order_acq_rel)) {
+          goto retry;
+        }
+        EpochDomain::instance().retire(curr, delete_node);
+        curr = to_node(next);
+        continue;
+      }
+      if (!comp(curr->data, key)) {
+        return !comp(key, curr->data);
+      }
+      prev = &curr->next;
+      curr = to_node(next);
+    }
+    return false;
+  }
+
+  /**
+   * Links `node`, which holds `key`, into sorted position, or frees it if an
+   * equal element is already present.
+   */
+  bool emplace_node(const T &key, Node *node) {
+    EpochDomain::Guard guard(EpochDomain::instance());
+    atomic<uintptr_t> *prev;
+    Node *curr;
+    for (;;) {
+      if (search(key, prev, curr)) {
+        delete node;
+        return false;
+      }
+      uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+      node->next.store(expected, memory_order_relaxed);
+      if (prev->compare_exchange_weak(expected,
+                                      reinterpret_cast<uintptr_t>(node),
+                                      memory_order_release,
+                                      memory_order_relaxed)) {
+        list_size.fetch_add(1, memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+
+  void delete_all() {
+    Node *node = to_node(head.load(memory_order_relaxed));
+    while (node != nullptr) {
+      Node *next = to_node(node->next.load(memory_order_relaxed));
+      delete node;
+      node = next;
+    }
+    head.store(0, memory_order_relaxed);
+    list_size.store(0, memory_order_relaxed);
+  }
+
+ public:
+  /**
+   * Default constructor. Creates an empty list.
+   */
+  ConcurrentList() : head(0), list_size(0) {
+  }
+
+  /**
+   * Copy constructor. `other` must not be modified concurrently.
+   */
+  ConcurrentList(const ConcurrentList &other)
+      : head(0), list_size(0), comp(other.comp) {
+    atomic<uintptr_t> *tail = &head;
+    for (Node *node = to_node(other.head.load(memory_order_acquire));
+         node != nullptr; node = to_node(node->next.load(memory_order_acquire))) {
+      if (is_marked(node->next.load(memory_order_acquire))) {
+        continue;
+      }
+      Node *copy = new Node(node->data);
+      tail->store(reinterpret_cast<uintptr_t>(copy), memory_order_relaxed);
+      tail = &copy->next;
+      list_size.fetch_add(1, memory_order_relaxed);
+    }
+  }
+
+  ConcurrentList &operator=(const ConcurrentList &other) = delete;
+
+  /**
+   * Destructor. No other thread may be using the list.
+   */
+  ~ConcurrentList() {
+    delete_all();
+  }
+
+  /**
+   * Returns the number of elements. A snapshot under concurrent updates.
+   */
+  size_t size() const {
+    return list_size.load(memory_order_relaxed);
+  }
+
+  /**
+   * Returns whether the list is empty, with the same caveat as `size()`.
+   */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * Adds `data` in sorted position. Returns false, leaving the list
+   * unchanged, if an equal element is already present.
+   */
+  bool insert(const T &data) {
+    return emplace_node(data, new Node(data));
+  }
+
+  /**
+   * Moves `data` into sorted position. Returns false if an equal element is
+   * already present.
+   */
+  bool insert(T &&data) {
+    Node *node = new Node(std::move(data));
+    return emplace_node(node->data, node);
+  }
+
+  /**
+   * Removes the element equal to `data`. Returns false if there is none.
+   */
+  bool remove(const T &data) {
+    EpochDomain::Guard guard(EpochDomain::instance());
+    atomic<uintptr_t> *prev;
+    Node *curr;
+    for (;;) {
+      if (!search(data, prev, curr)) {
+        return false;
+      }
+      uintptr_t next = curr->next.load(memory_order_acquire);
+      if (is_marked(next)) {
+        continue;
+      }
+      // Logically delete first; whoever wins this race owns the removal.
+      if (!curr->next.compare_exchange_weak(next, next | mark_bit,
+                                            memory_order_acq_rel,
+                                            memory_order_relaxed)) {
+        continue;
+      }
+      list_size.fetch_sub(1, memory_order_relaxed);
+      uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+      if (prev->compare_exchange_strong(expected, next,
+                                        memory_order_acq_rel)) {
+        EpochDomain::instance().retire(curr, delete_node);
+      }
+      else {
+        // Someone changed `prev`; let a fresh search do the unlinking.
+        search(data, prev, curr);
+      }
+      return true;
+    }
+  }
+
+  /**
+   * Returns whether an element equal to `data` is present. Wait-free: walks
+   * past marked nodes without helping to unlink them.
+   */
+  bool contains(const T &data) const {
+    EpochDomain::Guard guard(EpochDomain::instance());
+    Node *curr = to_node(head.load(memory_order_acquire));
+    while (curr != nullptr && comp(curr->data, data)) {
+      curr = to_node(curr->next.load(memory_order_acquire));
+    }
+    return curr != nullptr && !comp(data, curr->data) &&
+           !is_marked(curr->next.load(memory_order_acquire));
+  }
+
+  /**
+   * Removes every element. No other thread may be using the list.
+   */
+  void clear() {
+    delete_all();
+  }
+
+  /**
+   * Returns a string of the elements in order, in the form `[1, 2, 3]`.
+   * Under concurrent updates the result may mix states.
+   */
+  string to_string() const {
+    EpochDomain::Guard guard(EpochDomain::instance());
+    stringstream ss;
+    ss << "[";
+    bool first = true;
+    for (Node *node = to_node(head.load(memory_order_acquire));
+         node != nullptr; node = to_node(node->next.load(memory_order_acquire))) {
+      if (is_marked(node->next.load(memory_order_acquire))) {
+        continue;
+      }
+      if (!first) {
+        ss << ", ";
+      }
+      ss << node->data;
+      first = false;
+    }
+    ss << "]";
+    return ss.str();
+  }
+};
@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "concurrentlist.h"
+#include "linkedlist.h"
+
+using namespace std;
+
+// Membership-list throughput: every benchmark thread runs the same mix of
+// lookups and updates against one shared list of `key_range / 2` elements,
+// and reports operations per second summed over all threads.
+//
+//   ./list_bench --benchmark_filter=Membership
+
+namespace {
+
+const int key_range = 1024;
+
+// Baseline: the single-threaded LinkedList behind a mutex.
+class LockedList {
+ private:
+  mutex lock;
+  LinkedList<int> list;
+
+ public:
+  bool insert(int value) {
+    lock_guard<mutex> guard(lock);
+    if (list.find(value) != size_t(-1)) {
+      return false;
+    }
+    list.push_front(value);
+    return true;
+  }
+
+  bool remove(int value) {
+    lock_guard<mutex> guard(lock);
+    size_t index = list.find(value);
+    if (index == size_t(-1)) {
+      return false;
+    }
+    list.remove_at(index);
+    return true;
+  }
+
+  bool contains(int value) {
+    lock_guard<mutex> guard(lock);
+    return list.find(value) != size_t(-1);
+  }
+};
+
+// range(0) is the percentage of operations that are updates, split evenly
+// between inserts and removes; the rest are `contains`.
+template <typename S>
+void BM_Membership(benchmark::State &state) {
+  static S *set = nullptr;
+  if (state.thread_index() == 0) {
+    set = new S();
+    for (int key = 0; key < key_range; key += 2) {
+      set->insert(key);
+    }
+  }
+  int update_percent = state.range(0);
+  unsigned seed = state.thread_index() * 7919 + 1;
+  for (auto _ : state) {
+    seed = seed * 1103515245 + 12345;
+    int key = (seed >> 8) % key_range;
+    int roll = (seed >> 20) % 100;
+    if (roll < update_percent / 2) {
+      benchmark::DoNotOptimize(set->insert(key));
+    }
+    else if (roll < update_percent) {
+      benchmark::DoNotOptimize(set->remove(key));
+    }
+    else {
+      benchmark::DoNotOptimize(set->contains(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete set;
+    set = nullptr;
+  }
+}
+
+void MembershipArgs(benchmark::internal::Benchmark *b) {
+  int max_threads = max(2u, thread::hardware_concurrency());
+  b->ArgName("update%")->Arg(2)->Arg(20)->ThreadRange(1, max_threads);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Membership, LockedList)
+    ->Apply(MembershipArgs)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Membership, ConcurrentList<int>)
+    ->Apply(MembershipArgs)
+    ->UseRealTime();
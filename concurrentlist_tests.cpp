@@ -0,0 +1,139 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrentlist.h"
+
+using namespace std;
+using namespace testing;
+
+TEST(ConcurrentListCore, insertKeepsSortedAndUnique) {
+  ConcurrentList<int> list;
+
+  EXPECT_THAT(list.empty(), Eq(true));
+  EXPECT_THAT(list.insert(5), Eq(true));
+  EXPECT_THAT(list.insert(1), Eq(true));
+  EXPECT_THAT(list.insert(3), Eq(true));
+  EXPECT_THAT(list.insert(3), Eq(false));
+  EXPECT_THAT(list.size(), Eq(3));
+  EXPECT_THAT(list.to_string(), Eq("[1, 3, 5]"));
+  EXPECT_THAT(list.contains(3), Eq(true));
+  EXPECT_THAT(list.contains(4), Eq(false));
+}
+TEST(ConcurrentListCore, remove) {
+  ConcurrentList<int> list;
+  for (int i = 0; i < 6; i++) {
+    list.insert(i);
+  }
+
+  EXPECT_THAT(list.remove(0), Eq(true));
+  EXPECT_THAT(list.remove(3), Eq(true));
+  EXPECT_THAT(list.remove(5), Eq(true));
+  EXPECT_THAT(list.remove(3), Eq(false));
+  EXPECT_THAT(list.remove(9), Eq(false));
+  EXPECT_THAT(list.to_string(), Eq("[1, 2, 4]"));
+  EXPECT_THAT(list.size(), Eq(3));
+  EXPECT_THAT(list.contains(3), Eq(false));
+
+  list.clear();
+  EXPECT_THAT(list.to_string(), Eq("[]"));
+  EXPECT_THAT(list.insert(3), Eq(true));
+}
+TEST(ConcurrentListCore, copyAndCompare) {
+  ConcurrentList<string, greater<string>> list;
+  list.insert(string("b"));
+  list.insert("c");
+  list.insert("a");
+
+  ConcurrentList<string, greater<string>> copy(list);
+  list.remove("b");
+  EXPECT_THAT(list.to_string(), Eq("[c, a]"));
+  EXPECT_THAT(copy.to_string(), Eq("[c, b, a]"));
+  EXPECT_THAT(copy.size(), Eq(3));
+}
+TEST(ConcurrentListThreads, disjointWriters) {
+  // Each writer owns the keys congruent to its id, inserting them all and
+  // then removing the odd ones, while readers poll keys that never change.
+  const int writers = 4;
+  const int per_writer = 1000;
+  ConcurrentList<int> list;
+  list.insert(-1);
+  atomic<bool> done(false);
+  atomic<bool> reader_ok(true);
+
+  vector<thread> threads;
+  for (int w = 0; w < writers; w++) {
+    threads.emplace_back([&, w] {
+      for (int i = 0; i < per_writer; i++) {
+        list.insert(i * writers + w);
+      }
+      for (int i = 1; i < per_writer; i += 2) {
+        list.remove(i * writers + w);
+      }
+    });
+  }
+  for (int r = 0; r < 2; r++) {
+    threads.emplace_back([&] {
+      while (!done) {
+        if (!list.contains(-1) || list.contains(-2)) {
+          reader_ok = false;
+        }
+      }
+    });
+  }
+  for (int w = 0; w < writers; w++) {
+    threads[w].join();
+  }
+  done = true;
+  for (size_t t = writers; t < threads.size(); t++) {
+    threads[t].join();
+  }
+
+  EXPECT_THAT(reader_ok.load(), Eq(true));
+  EXPECT_THAT(list.size(), Eq(1 + writers * per_writer / 2));
+  bool all_match = true;
+  for (int key = 0; key < writers * per_writer; key++) {
+    bool expected = (key / writers) % 2 == 0;
+    all_match = all_match && (list.contains(key) == expected);
+  }
+  EXPECT_THAT(all_match, Eq(true));
+}
+TEST(ConcurrentListThreads, contendedKeys) {
+  // Every thread races to insert and remove the same small key range; the
+  // number of successful inserts minus removes must match what is left.
+  const int thread_count = 6;
+  const int keys = 32;
+  ConcurrentList<int> list;
+  atomic<long> balance(0);
+
+  vector<thread> threads;
+  for (int t = 0; t < thread_count; t++) {
+    threads.emplace_back([&, t] {
+      unsigned seed = t * 7919 + 1;
+      for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        int key = (seed >> 16) % keys;
+        if ((seed >> 8) & 1) {
+          balance += list.insert(key) ? 1 : 0;
+        }
+        else {
+          balance -= list.remove(key) ? 1 : 0;
+        }
+      }
+    });
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  long present = 0;
+  for (int key = 0; key < keys; key++) {
+    present += list.contains(key) ? 1 : 0;
+  }
+  EXPECT_THAT(present, Eq(balance.load()));
+  EXPECT_THAT(list.size(), Eq(static_cast<size_t>(present)));
+}
@@ -1,41 +1,309 @@
 #pragma once
 
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#include "opstats.h"
+#include "rangeformat.h"
 
 using namespace std;
 
-template <typename T>
+/**
+ * Singly- or doubly-linked list. With `Doubly` set, every node also carries a
+ * `prev` pointer, which makes `pop_back` O(1) and lets indexed operations walk
+ * from whichever end is closer. Both layouts keep a tail pointer, so
+ * `push_back` is always O(1).
+ *
+ * Nodes are obtained from `Alloc` (rebound to the node type), so a pooling
+ * allocator such as `NodePool<T>` can replace the per-node `new`/`delete`.
+ */
+template <typename T, typename Alloc = allocator<T>, bool Doubly = false>
 class LinkedList {
  private:
+  struct NoLink {};
+
   class Node {
    public:
     T data;
     Node *next;
+    [[no_unique_address]] conditional_t<Doubly, Node *, NoLink> prev;
 
-    Node(T data) {
-      this->data = data;
+    template <typename... Args>
+    Node(Args &&...args) : data(std::forward<Args>(args)...) {
       this->next = nullptr;
-    }
-
-    Node(T data, Node *next) {
-      this->data = data;
-      this->next = next;
+      if constexpr (Doubly) {
+        this->prev = nullptr;
+      }
     }
   };
 
+  using NodeAlloc = typename allocator_traits<Alloc>::template rebind_alloc<Node>;
+  using NodeTraits = allocator_traits<NodeAlloc>;
+
   size_t list_size;
   Node *list_front;
+  Node *list_back;
+  [[no_unique_address]] NodeAlloc node_alloc;
+  [[no_unique_address]] mutable OpCounters counters;
+
+  template <typename... Args>
+  Node *new_node(Args &&...args) {
+    Node *node = NodeTraits::allocate(node_alloc, 1);
+    try {
+      NodeTraits::construct(node_alloc, node, std::forward<Args>(args)...);
+    }
+    catch (...) {
+      NodeTraits::deallocate(node_alloc, node, 1);
+      throw;
+    }
+    counters.add_node_allocated();
+    return node;
+  }
+
+  void delete_node(Node *node) {
+    NodeTraits::destroy(node_alloc, node);
+    NodeTraits::deallocate(node_alloc, node, 1);
+    counters.add_node_freed();
+  }
+
+  /**
+   * Returns the node at the given index, which must be valid. Doubly-linked
+   * lists walk backwards from the tail when that is the shorter route.
+   */
+  Node *node_at(size_t index) const {
+    if (index + 1 == list_size) {
+      return list_back;
+    }
+    if constexpr (Doubly) {
+      if (index > list_size / 2) {
+        counters.add_hops(list_size - 1 - index);
+        Node *ptr = list_back;
+        for (size_t i = list_size - 1; i > index; i--) {
+          ptr = ptr->prev;
+        }
+        return ptr;
+      }
+    }
+    counters.add_hops(index);
+    Node *ptr = list_front;
+    for (size_t i = 0; i < index; i++) {
+      ptr = ptr->next;
+    }
+    return ptr;
+  }
+
+  /**
+   * Links `node` into the chain directly after `prev`, or at the front if
+   * `prev` is null.
+   */
+  void link_after(Node *prev, Node *node) {
+    node->next = (prev == nullptr) ? list_front : prev->next;
+    if constexpr (Doubly) {
+      node->prev = prev;
+      if (node->next != nullptr) {
+        node->next->prev = node;
+      }
+    }
+    if (prev == nullptr) {
+      list_front = node;
+    }
+    else {
+      prev->next = node;
+    }
+    if (node->next == nullptr) {
+      list_back = node;
+    }
+    list_size++;
+    counters.note_size(list_size);
+  }
+
+  /**
+   * Unlinks `node` from the chain, given its predecessor (null if `node` is
+   * the front). Does not free the node.
+   */
+  void unlink(Node *prev, Node *node) {
+    if (prev == nullptr) {
+      list_front = node->next;
+    }
+    else {
+      prev->next = node->next;
+    }
+    if (node->next == nullptr) {
+      list_back = prev;
+    }
+    else if constexpr (Doubly) {
+      node->next->prev = prev;
+    }
+    list_size--;
+  }
+
+  /**
+   * Takes over the chain of `other`, leaving it empty. The caller must make
+   * sure this list is empty and that the nodes can be freed through our
+   * allocator.
+   */
+  void steal_from(LinkedList &other) {
+    list_size = other.list_size;
+    list_front = other.list_front;
+    list_back = other.list_back;
+    other.list_size = 0;
+    other.list_front = nullptr;
+    other.list_back = nullptr;
+    counters.note_size(list_size);
+  }
+
+  /**
+   * Links the whole chain of `other` in directly after `prev` (at the front
+   * if `prev` is null), leaving `other` empty. Runs in O(1) time when the
+   * two allocators compare equal; otherwise the elements are moved into new
+   * nodes one by one.
+   */
+  void splice_chain(Node *prev, LinkedList &other) {
+    if (&other == this || other.list_front == nullptr) {
+      return;
+    }
+    if constexpr (!NodeTraits::is_always_equal::value) {
+      if (!(node_alloc == other.node_alloc)) {
+        for (Node *ptr = other.list_front; ptr != nullptr; ptr = ptr->next) {
+          Node *node = new_node(std::move(ptr->data));
+          link_after(prev, node);
+          prev = node;
+        }
+        other.clear();
+        return;
+      }
+    }
+
+    Node *next = (prev == nullptr) ? list_front : prev->next;
+    other.list_back->next = next;
+    if constexpr (Doubly) {
+      other.list_front->prev = prev;
+      if (next != nullptr) {
+        next->prev = other.list_back;
+      }
+    }
+    if (prev == nullptr) {
+      list_front = other.list_front;
+    }
+    else {
+      prev->next = other.list_front;
+    }
+    if (next == nullptr) {
+      list_back = other.list_back;
+    }
+    list_size += other.list_size;
+    counters.note_size(list_size);
+
+    other.list_size = 0;
+    other.list_front = nullptr;
+    other.list_back = nullptr;
+  }
+
+  /**
+   * Creates a list that adopts an existing chain of `size` nodes, from
+   * `front` to `back`, allocated through `alloc`.
+   */
+  LinkedList(const NodeAlloc &alloc, size_t size, Node *front, Node *back)
+      : node_alloc(alloc) {
+    list_size = size;
+    list_front = front;
+    list_back = back;
+    counters.note_size(list_size);
+  }
+
+  /**
+   * Appends deep copies of every element of `other`. Runs in O(N) time.
+   */
+  void copy_from(const LinkedList &other) {
+    for (Node *ptr = other.list_front; ptr != nullptr; ptr = ptr->next) {
+      link_after(list_back, new_node(ptr->data));
+    }
+  }
 
  public:
+  /**
+   * Forward iterator over the elements, following `next` pointers.
+   */
+  template <bool IsConst>
+  class Iterator {
+   private:
+    Node *node = nullptr;
+
+    friend class LinkedList;
+    friend class Iterator<!IsConst>;
+
+    explicit Iterator(Node *node) : node(node) {
+    }
+
+   public:
+    using iterator_category = forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = conditional_t<IsConst, const T *, T *>;
+    using reference = conditional_t<IsConst, const T &, T &>;
+
+    Iterator() = default;
+
+    /**
+     * Converts an `iterator` to a `const_iterator`.
+     */
+    template <bool OtherConst>
+      requires(IsConst && !OtherConst)
+    Iterator(const Iterator<OtherConst> &other) : node(other.node) {
+    }
+
+    reference operator*() const {
+      return node->data;
+    }
+
+    pointer operator->() const {
+      return &node->data;
+    }
+
+    Iterator &operator++() {
+      node = node->next;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      node = node->next;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.node == b.node;
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
   /**
    * Default constructor. Creates an empty `LinkedList`.
    */
   LinkedList() {
     list_size = 0;
     list_front = nullptr;
+    list_back = nullptr;
+  }
+
+  /**
+   * Creates an empty `LinkedList` whose nodes come from the given allocator,
+   * rebound to the node type. A `NodePool` keeps sharing its state with the
+   * caller's copy.
+   */
+  explicit LinkedList(const Alloc &alloc) : node_alloc(alloc) {
+    list_size = 0;
+    list_front = nullptr;
+    list_back = nullptr;
   }
 
   /**
@@ -43,7 +311,7 @@ class LinkedList {
    * size is 0).
    */
   bool empty() const {
-    return list_size == 0;;
+    return list_size == 0;
   }
 
   /**
@@ -56,30 +324,51 @@ class LinkedList {
   /**
    * Adds the given `T` to the front of the `LinkedList`.
    */
-  void push_front(T data) {
-    Node* ptr = new Node(data);
-    ptr->next = list_front;
-    list_front = ptr;
-    list_size++;
+  void push_front(const T &data) {
+    emplace_front(data);
   }
 
   /**
-   * Adds the given `T` to the back of the `LinkedList`.
+   * Moves the given `T` onto the front of the `LinkedList`.
    */
-  void push_back(T data) {
-    Node* newNode = new Node(data);
+  void push_front(T &&data) {
+    emplace_front(std::move(data));
+  }
 
-    if (list_front == nullptr) {
-      list_front = newNode;
-    }
-    else {
-      Node* ptr = list_front;
-      while (ptr->next != nullptr) {
-        ptr = ptr->next;
-      }
-      ptr->next = newNode;
-    }
-    list_size++;
+  /**
+   * Constructs a `T` from the given arguments at the front of the
+   * `LinkedList`, and returns a reference to it.
+   */
+  template <typename... Args>
+  T &emplace_front(Args &&...args) {
+    Node* node = new_node(std::forward<Args>(args)...);
+    link_after(nullptr, node);
+    return node->data;
+  }
+
+  /**
+   * Adds the given `T` to the back of the `LinkedList`. Runs in O(1) time.
+   */
+  void push_back(const T &data) {
+    emplace_back(data);
+  }
+
+  /**
+   * Moves the given `T` onto the back of the `LinkedList`. Runs in O(1) time.
+   */
+  void push_back(T &&data) {
+    emplace_back(std::move(data));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments at the back of the
+   * `LinkedList`, and returns a reference to it. Runs in O(1) time.
+   */
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    Node* node = new_node(std::forward<Args>(args)...);
+    link_after(list_back, node);
+    return node->data;
   }
 
   /**
@@ -91,18 +380,18 @@ class LinkedList {
     if (list_size == 0) {
       throw runtime_error("List is empty.");
     }
-    
+
     Node* ptr = list_front;
-    T deletedValue = ptr->data;
-    list_front = list_front->next;
-    delete ptr;
-    list_size--;
+    T deletedValue = std::move(ptr->data);
+    unlink(nullptr, ptr);
+    delete_node(ptr);
 
     return deletedValue;
   }
 
   /**
-   * Removes the element at the back of the `LinkedList`.
+   * Removes the element at the back of the `LinkedList`. Runs in O(1) time
+   * when doubly-linked, O(N) otherwise.
    *
    * If the `LinkedList` is empty, throws a `runtime_error`.
    */
@@ -111,23 +400,18 @@ class LinkedList {
       throw runtime_error("List is empty.");
     }
 
-    if (list_front->next == nullptr) {
-      T deletedValue = list_front->data;
-      delete list_front;
-      list_front = nullptr;
-      list_size--;
-      return deletedValue;
+    Node* ptr = list_back;
+    Node* prev = nullptr;
+    if constexpr (Doubly) {
+      prev = ptr->prev;
     }
-
-    Node* ptr = list_front;
-    while (ptr->next->next != nullptr) {
-      ptr = ptr->next;
+    else if (list_size > 1) {
+      prev = node_at(list_size - 2);
     }
 
-    T deletedValue = ptr->next->data;
-    delete(ptr->next);
-    ptr->next = nullptr;
-    list_size--;
+    T deletedValue = std::move(ptr->data);
+    unlink(prev, ptr);
+    delete_node(ptr);
 
     return deletedValue;
   }
@@ -140,12 +424,15 @@ class LinkedList {
     Node* ptr = list_front;
     while (ptr != nullptr) {
       Node* next = ptr->next;
-      delete(ptr);
+      delete_node(ptr);
       ptr = next;
-      list_size--;
     }
     list_front = nullptr;
+    list_back = nullptr;
     list_size = 0;
+    if constexpr (requires(NodeAlloc &a) { a.release(); }) {
+      node_alloc.release();
+    }
   }
 
   /**
@@ -164,11 +451,7 @@ class LinkedList {
     if (index >= list_size) {
       throw out_of_range("Index is invalid.");
     }
-    Node* ptr = list_front;
-    for (size_t i = 0; i < index; i++) {
-      ptr = ptr->next;
-    }
-    return ptr->data;
+    return node_at(index)->data;
   }
 
   /**
@@ -176,24 +459,21 @@ class LinkedList {
    *
    * Must run in O(N) time.
    */
-  LinkedList(const LinkedList &other) {
+  LinkedList(const LinkedList &other)
+      : node_alloc(NodeTraits::select_on_container_copy_construction(
+            other.node_alloc)) {
     list_front = nullptr;
+    list_back = nullptr;
     list_size = 0;
-    Node* original = other.list_front;
-    if (original == nullptr) {
-      return;
-    }
-    
-    list_front = new Node(original->data);
-    Node* llcopy = list_front;
-    original = original->next;
+    copy_from(other);
+  }
 
-    while (original != nullptr) {
-      llcopy->next = new Node(original->data);
-      llcopy = llcopy->next;
-      original = original->next;
-    }
-    list_size = other.list_size;
+  /**
+   * Move constructor. Takes over the nodes of the given `LinkedList`, which
+   * is left empty. Runs in O(1) time.
+   */
+  LinkedList(LinkedList &&other) noexcept : node_alloc(other.node_alloc) {
+    steal_from(other);
   }
 
   /**
@@ -208,25 +488,43 @@ class LinkedList {
     }
 
     clear();
-
-    Node* original = other.list_front;
-    if (original == nullptr) {
-      list_front = nullptr;
-      list_size = 0;
-      return *this;
+    if constexpr (NodeTraits::propagate_on_container_copy_assignment::value) {
+      node_alloc = other.node_alloc;
     }
+    copy_from(other);
 
-    list_front = new Node(original->data);
-    Node* llcopy = list_front;
+    return *this;
+  }
 
-    original = original->next;
+  /**
+   * Move assignment operator. Frees the current nodes and takes over the
+   * nodes of the given `LinkedList`, which is left empty. Runs in O(1) time
+   * unless the two allocators differ and cannot be propagated, in which case
+   * the elements are moved one by one.
+   */
+  LinkedList &operator=(LinkedList &&other) noexcept(
+      NodeTraits::propagate_on_container_move_assignment::value ||
+      NodeTraits::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
 
-    while (original != nullptr) {
-      llcopy->next = new Node(original->data);
-      llcopy = llcopy->next;
-      original = original->next;
+    clear();
+    if constexpr (NodeTraits::propagate_on_container_move_assignment::value) {
+      node_alloc = other.node_alloc;
+      steal_from(other);
+    }
+    else {
+      if (node_alloc == other.node_alloc) {
+        steal_from(other);
+      }
+      else {
+        for (Node *ptr = other.list_front; ptr != nullptr; ptr = ptr->next) {
+          link_after(list_back, new_node(std::move(ptr->data)));
+        }
+        other.clear();
+      }
     }
-    list_size = other.list_size;
 
     return *this;
   }
@@ -237,18 +535,25 @@ class LinkedList {
    * time.
    */
   string to_string() const {
-    stringstream ss;
-    Node* ptr = list_front;
-    ss << "[";
-    while (ptr != nullptr) {
-      ss << ptr->data;
-      if (ptr->next != nullptr) {
-        ss << ", ";
-      }
-      ptr = ptr->next;
-    }
-    ss << "]";
-    return ss.str();
+    string out;
+    write_to(out);
+    return out;
+  }
+
+  /**
+   * Appends the `to_string` form to `out`, converting numbers with
+   * `to_chars` instead of a `stringstream` (see `rangeformat.h`).
+   */
+  void write_to(string &out) const {
+    format_range(*this, [&](const char *p, size_t n) { out.append(p, n); });
+  }
+
+  /**
+   * Writes the `to_string` form to `os` without building the string first.
+   * The stream's formatting flags are not used.
+   */
+  void write_to(ostream &os) const {
+    format_range(*this, [&](const char *p, size_t n) { os.write(p, n); });
   }
 
   /**
@@ -265,6 +570,7 @@ class LinkedList {
       ptr = ptr->next;
       index++;
     }
+    counters.add_hops(index);
     if (ptr->data != data) {
       return -1;
     }
@@ -272,49 +578,60 @@ class LinkedList {
   }
 
   /**
-   * Remove the element at the specified index in this list.
+   * Remove the element at the specified index in this list. Doubly-linked
+   * lists walk from whichever end is closer.
    *
    * If the index is invalid, throws `out_of_range`.
    */
   void remove_at(size_t index) {
-    if (index == 0) {
-      Node* target = list_front;
-      list_front = list_front->next;
-      delete target;
-      list_size--;
-      return;
+    if (index >= list_size) {
+      throw out_of_range("Index not in the range");
     }
 
-    if (index >= list_size || index < 0) {
-      throw out_of_range("Index not in the range");
+    Node* prev = nullptr;
+    Node* target = nullptr;
+    if constexpr (Doubly) {
+      target = node_at(index);
+      prev = target->prev;
     }
-    Node* ptr = list_front;
-    for (size_t i = 0; i + 1 < index; i++) {
-      ptr = ptr->next;
+    else {
+      prev = (index == 0) ? nullptr : node_at(index - 1);
+      target = (prev == nullptr) ? list_front : prev->next;
     }
-    Node* target = ptr->next;
-    ptr->next = target->next;
-    delete target;
-    list_size--;
+    unlink(prev, target);
+    delete_node(target);
   }
 
   /**
    * Inserts the given `T` as a new element in the `LinkedList` after
    * the given index. If the index is invalid, throws `out_of_range`.
    */
-  void insert_after(size_t index, T data) {
-    if (index >= list_size || index < 0) {
+  void insert_after(size_t index, const T &data) {
+    emplace_after(index, data);
+  }
+
+  /**
+   * Moves the given `T` into the `LinkedList` after the given index. If the
+   * index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, T &&data) {
+    emplace_after(index, std::move(data));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments as a new element after the
+   * given index, and returns a reference to it. If the index is invalid,
+   * throws `out_of_range`.
+   */
+  template <typename... Args>
+  T &emplace_after(size_t index, Args &&...args) {
+    if (index >= list_size) {
       throw out_of_range("Index not in the range");
     }
 
-    Node* ptr = list_front;
-    for (size_t i = 0; i < index; i++) {
-      ptr = ptr->next;
-    }
-    Node* temp = ptr->next;
-    ptr->next = new Node(data);
-    ptr->next->next = temp;
-    list_size++;
+    Node* node = new_node(std::forward<Args>(args)...);
+    link_after(node_at(index), node);
+    return node->data;
   }
 
   /**
@@ -337,14 +654,8 @@ class LinkedList {
       Node* next = ptr->next;
 
       if ((count % 2) == 0) {
-        if (previous == nullptr) {
-          list_front = next;
-        }
-        else {
-          previous->next = next;
-        }
-        delete ptr;
-        list_size--;
+        unlink(previous, ptr);
+        delete_node(ptr);
       }
       else {
         previous = ptr;
@@ -354,6 +665,124 @@ class LinkedList {
     }
   }
 
+  /**
+   * Moves every node of `other` onto the back of this list, leaving `other`
+   * empty. Nodes are relinked, not copied, so this runs in O(1) time when
+   * the two allocators compare equal (always, for the default allocator).
+   */
+  void splice_back(LinkedList &&other) {
+    splice_chain(list_back, other);
+  }
+
+  /**
+   * Moves every node of `other` onto the front of this list, leaving `other`
+   * empty. Runs in O(1) time, like `splice_back`.
+   */
+  void splice_front(LinkedList &&other) {
+    splice_chain(nullptr, other);
+  }
+
+  /**
+   * Moves every node of `other` into this list after the given index,
+   * leaving `other` empty. Costs one walk to the index (from the closer end
+   * for doubly-linked lists) and no allocation when the allocators compare
+   * equal. If the index is invalid, throws `out_of_range`.
+   */
+  void splice_after(size_t index, LinkedList &&other) {
+    if (index >= list_size) {
+      throw out_of_range("Index not in the range");
+    }
+    splice_chain(node_at(index), other);
+  }
+
+  /**
+   * Splits the list at the given index: this list keeps the elements before
+   * it, and the elements from it onwards are returned as a new list sharing
+   * this list's allocator. Costs one walk to the index and no allocation.
+   * An index equal to `size()` returns an empty list. If the index is
+   * greater, throws `out_of_range`.
+   */
+  LinkedList split_at(size_t index) {
+    if (index > list_size) {
+      throw out_of_range("Index not in the range");
+    }
+    if (index == list_size) {
+      return LinkedList(node_alloc, 0, nullptr, nullptr);
+    }
+
+    Node *prev = (index == 0) ? nullptr : node_at(index - 1);
+    Node *first = (prev == nullptr) ? list_front : prev->next;
+    LinkedList rest(node_alloc, list_size - index, first, list_back);
+    if constexpr (Doubly) {
+      first->prev = nullptr;
+    }
+    if (prev == nullptr) {
+      list_front = nullptr;
+    }
+    else {
+      prev->next = nullptr;
+    }
+    list_back = prev;
+    list_size = index;
+    return rest;
+  }
+
+  /**
+   * Returns an iterator to the first element.
+   */
+  iterator begin() {
+    return iterator(list_front);
+  }
+
+  /**
+   * Returns an iterator one past the last element.
+   */
+  iterator end() {
+    return iterator(nullptr);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(list_front);
+  }
+
+  const_iterator end() const {
+    return const_iterator(nullptr);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  /**
+   * Returns a copy of the allocator used for nodes. Stateful allocators such
+   * as `NodePool` share their state with the copy, so it can be used to read
+   * allocation counters.
+   */
+  NodeAlloc node_allocator() const {
+    return node_alloc;
+  }
+
+  /**
+   * Returns a snapshot of this list's operation counters (see `opstats.h`).
+   * All zeros unless built with `CONTAINER_STATS`.
+   */
+  OpStats stats() const {
+    return counters.snapshot();
+  }
+
+  /**
+   * Zeroes the operation counters. The peak size restarts from the current
+   * size.
+   */
+  void reset_stats() {
+    counters.reset();
+    counters.note_size(list_size);
+  }
+
   /**
    * Returns a pointer to the node at the front of the `LinkedList`. For
    * autograder testing purposes only.
@@ -361,4 +790,27 @@ class LinkedList {
   void *front() const {
     return this->list_front;
   }
-};
\ No newline at end of file
+};
+
+/**
+ * Doubly-linked `LinkedList`: O(1) at both ends, bidirectional indexing.
+ */
+template <typename T, typename Alloc = allocator<T>>
+using DList = LinkedList<T, Alloc, true>;
+
+#ifdef __cpp_lib_format
+/**
+ * `std::format("{}", list)` prints the `to_string` form.
+ */
+namespace std {
+template <typename T, typename Alloc, bool Doubly>
+struct formatter<LinkedList<T, Alloc, Doubly>, char> : RangeFormatter {};
+
+#ifdef __cpp_lib_format_ranges
+// Keep the generic range formatter out of the way.
+template <typename T, typename Alloc, bool Doubly>
+inline constexpr range_format format_kind<LinkedList<T, Alloc, Doubly>> =
+    range_format::disabled;
+#endif
+}  // namespace std
+#endif
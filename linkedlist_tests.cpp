@@ -1,7 +1,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include "linkedlist.h"
+#include "nodepool.h"
 
 using namespace std;
 using namespace testing;
@@ -357,3 +364,411 @@ TEST(LinkedListExtras, removeEvensEmpty) {
 }
 
 
+
+//Doubly
+TEST(LinkedListDoubly, pushPopBothEnds) {
+  DList<int> ll;
+
+  ll.push_back(2);
+  ll.push_back(3);
+  ll.push_front(1);
+  ll.push_front(0);
+
+  EXPECT_THAT(ll.to_string(), Eq("[0, 1, 2, 3]"));
+  EXPECT_THAT(ll.pop_back(), Eq(3));
+  EXPECT_THAT(ll.pop_back(), Eq(2));
+  EXPECT_THAT(ll.pop_front(), Eq(0));
+  EXPECT_THAT(ll.pop_back(), Eq(1));
+  EXPECT_THAT(ll.empty(), Eq(true));
+  EXPECT_THROW(ll.pop_back(), runtime_error);
+
+  ll.push_back(4);
+  EXPECT_THAT(ll.at(0), Eq(4));
+}
+TEST(LinkedListDoubly, atFromEitherEnd) {
+  DList<int> ll;
+
+  for (int i = 0; i < 9; i++) {
+    ll.push_back(i);
+  }
+  for (int i = 0; i < 9; i++) {
+    EXPECT_THAT(ll.at(i), Eq(i));
+  }
+  EXPECT_THROW(ll.at(9), out_of_range);
+}
+TEST(LinkedListDoubly, removeAndInsertNearBack) {
+  DList<int> ll;
+
+  for (int i = 0; i < 6; i++) {
+    ll.push_back(i);
+  }
+  ll.remove_at(4);
+  ll.insert_after(3, 9);
+  ll.remove_at(5);
+  ll.insert_after(4, 7);
+  ll.remove_at(0);
+
+  EXPECT_THAT(ll.to_string(), Eq("[1, 2, 3, 9, 7]"));
+  EXPECT_THAT(ll.pop_back(), Eq(7));
+  EXPECT_THAT(ll.pop_back(), Eq(9));
+}
+TEST(LinkedListDoubly, removeEvensKeepsTail) {
+  DList<int> ll;
+
+  for (int i = 0; i < 5; i++) {
+    ll.push_back(i);
+  }
+  ll.remove_evens();
+  EXPECT_THAT(ll.to_string(), Eq("[1, 3]"));
+  ll.push_back(5);
+  EXPECT_THAT(ll.pop_back(), Eq(5));
+  EXPECT_THAT(ll.pop_back(), Eq(3));
+  EXPECT_THAT(ll.pop_back(), Eq(1));
+}
+TEST(LinkedListDoubly, copyAndAssign) {
+  DList<int> l1;
+  l1.push_back(1);
+  l1.push_back(2);
+
+  DList<int> l2(l1);
+  DList<int> l3;
+  l3.push_back(8);
+  l3 = l1;
+  l1.pop_back();
+
+  EXPECT_THAT(l2.pop_back(), Eq(2));
+  EXPECT_THAT(l3.pop_back(), Eq(2));
+  EXPECT_THAT(l1.size(), Eq(1));
+}
+TEST(LinkedListDoubly, singlyTailAfterRemovals) {
+  LinkedList<int> ll;
+
+  ll.push_back(1);
+  ll.push_back(2);
+  ll.push_back(3);
+  ll.remove_at(2);
+  ll.push_back(4);
+  ll.remove_evens();
+  ll.push_back(5);
+
+  EXPECT_THAT(ll.to_string(), Eq("[2, 5]"));
+  EXPECT_THROW(ll.remove_at(2), out_of_range);
+}
+
+//Pool
+TEST(LinkedListPool, pooledListBehavesLikeList) {
+  LinkedList<int, NodePool<int>> ll;
+
+  ll.push_back(2);
+  ll.push_back(3);
+  ll.push_front(1);
+  ll.insert_after(2, 4);
+  ll.remove_at(0);
+
+  EXPECT_THAT(ll.to_string(), Eq("[2, 3, 4]"));
+  EXPECT_THAT(ll.pop_back(), Eq(4));
+  EXPECT_THAT(ll.pop_front(), Eq(2));
+}
+TEST(LinkedListPool, slabsAndReuse) {
+  LinkedList<int, NodePool<int, 64>> ll;
+
+  for (int i = 0; i < 200; i++) {
+    ll.push_back(i);
+  }
+  NodePoolStats stats = ll.node_allocator().stats();
+  EXPECT_THAT(stats.allocations, Eq(200));
+  EXPECT_THAT(stats.heap_allocations, Eq(4));
+  EXPECT_THAT(stats.slabs, Eq(4));
+  EXPECT_THAT(stats.live, Eq(200));
+
+  for (int i = 0; i < 50; i++) {
+    ll.pop_front();
+  }
+  for (int i = 0; i < 50; i++) {
+    ll.push_back(i);
+  }
+  stats = ll.node_allocator().stats();
+  EXPECT_THAT(stats.reuses, Eq(50));
+  EXPECT_THAT(stats.heap_allocations, Eq(4));
+}
+TEST(LinkedListPool, clearReturnsSlabs) {
+  LinkedList<int, NodePool<int, 8>> ll;
+
+  for (int i = 0; i < 20; i++) {
+    ll.push_back(i);
+  }
+  EXPECT_THAT(ll.node_allocator().stats().slabs, Eq(3));
+  ll.clear();
+  EXPECT_THAT(ll.node_allocator().stats().slabs, Eq(0));
+  EXPECT_THAT(ll.node_allocator().stats().live, Eq(0));
+
+  ll.push_back(5);
+  EXPECT_THAT(ll.at(0), Eq(5));
+}
+TEST(LinkedListPool, copiesGetOwnPool) {
+  DList<string, NodePool<string>> l1;
+  l1.push_back("a");
+  l1.push_back("b");
+
+  DList<string, NodePool<string>> l2(l1);
+  DList<string, NodePool<string>> l3;
+  l3 = l1;
+  l1.clear();
+
+  EXPECT_THAT(l2.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(l3.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(l2.node_allocator().stats().live, Eq(2));
+  EXPECT_THAT(l1.node_allocator().stats().slabs, Eq(0));
+}
+TEST(LinkedListPool, reboundPoolsShareState) {
+  NodePool<int, 16> pool;
+  NodePool<double, 16> rebound(pool);
+  EXPECT_THAT(rebound == pool, Eq(true));
+  using IntPool = NodePool<int, 16>;
+  EXPECT_THAT(IntPool(rebound) == pool, Eq(true));
+  EXPECT_THAT(IntPool() == pool, Eq(false));
+
+  // Both lists draw their nodes from the pool passed in.
+  LinkedList<int, NodePool<int, 16>> l1(pool);
+  DList<int, NodePool<int, 16>> l2(pool);
+  for (int i = 0; i < 10; i++) {
+    l1.push_back(i);
+    l2.push_front(i);
+  }
+  EXPECT_THAT(l1.node_allocator() == pool, Eq(true));
+  NodePoolStats stats = pool.stats();
+  EXPECT_THAT(stats.allocations, Eq(20));
+  EXPECT_THAT(stats.live, Eq(20));
+  // Singly and doubly linked nodes differ in size, so each has its own slab.
+  EXPECT_THAT(stats.slabs, Eq(2));
+
+  l1.clear();
+  EXPECT_THAT(pool.stats().live, Eq(10));
+  EXPECT_THAT(pool.stats().slabs, Eq(2));
+  l2.clear();
+  EXPECT_THAT(pool.stats().slabs, Eq(0));
+  l1.push_back(1);
+  EXPECT_THAT(l1.to_string(), Eq("[1]"));
+}
+
+//Move
+TEST(LinkedListMove, moveOnlyElements) {
+  DList<unique_ptr<int>> ll;
+
+  ll.push_back(make_unique<int>(2));
+  ll.push_front(make_unique<int>(1));
+  ll.emplace_back(new int(4));
+  ll.emplace_after(1, new int(3));
+
+  EXPECT_THAT(ll.size(), Eq(4));
+  EXPECT_THAT(*ll.at(2), Eq(3));
+  EXPECT_THAT(*ll.pop_front(), Eq(1));
+  EXPECT_THAT(*ll.pop_back(), Eq(4));
+}
+TEST(LinkedListMove, emplaceReturnsElement) {
+  LinkedList<string> ll;
+
+  string &s = ll.emplace_back(3, 'x');
+  EXPECT_THAT(s, Eq("xxx"));
+  ll.emplace_front("a");
+  EXPECT_THAT(ll.to_string(), Eq("[a, xxx]"));
+}
+TEST(LinkedListMove, moveConstructAndAssign) {
+  LinkedList<string> l1;
+  l1.push_back("a");
+  l1.push_back("b");
+  void *front = l1.front();
+
+  LinkedList<string> l2(std::move(l1));
+  EXPECT_THAT(l2.front(), Eq(front));
+  EXPECT_THAT(l2.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(l1.empty(), Eq(true));
+
+  l1.push_back("c");
+  l1 = std::move(l2);
+  EXPECT_THAT(l1.front(), Eq(front));
+  EXPECT_THAT(l1.to_string(), Eq("[a, b]"));
+  EXPECT_THAT(l2.size(), Eq(0));
+
+  l2.push_back("d");
+  EXPECT_THAT(l2.pop_back(), Eq("d"));
+}
+TEST(LinkedListMove, pooledMoveKeepsNodes) {
+  LinkedList<int, NodePool<int>> l1;
+  l1.push_back(1);
+  l1.push_back(2);
+
+  LinkedList<int, NodePool<int>> l2;
+  l2.push_back(9);
+  l2 = std::move(l1);
+
+  EXPECT_THAT(l2.to_string(), Eq("[1, 2]"));
+  EXPECT_THAT(l2.node_allocator().stats().live, Eq(2));
+  l1.push_back(3);
+  EXPECT_THAT(l1.to_string(), Eq("[3]"));
+}
+
+//Iterators
+TEST(LinkedListIterators, rangeFor) {
+  LinkedList<int> ll;
+  ll.push_back(1);
+  ll.push_back(2);
+  ll.push_back(3);
+
+  vector<int> seen;
+  for (int x : ll) {
+    seen.push_back(x);
+  }
+  EXPECT_THAT(seen, ElementsAre(1, 2, 3));
+
+  for (int &x : ll) {
+    x += 10;
+  }
+  EXPECT_THAT(ll.to_string(), Eq("[11, 12, 13]"));
+}
+TEST(LinkedListIterators, algorithms) {
+  DList<int> ll;
+  ll.push_back(4);
+  ll.push_back(7);
+  ll.push_back(2);
+
+  static_assert(forward_iterator<LinkedList<int>::iterator>);
+  static_assert(forward_iterator<DList<int>::const_iterator>);
+
+  EXPECT_THAT(*max_element(ll.begin(), ll.end()), Eq(7));
+  EXPECT_THAT(accumulate(ll.cbegin(), ll.cend(), 0), Eq(13));
+  EXPECT_THAT(count(ll.begin(), ll.end(), 2), Eq(1));
+  EXPECT_THAT(find(ll.begin(), ll.end(), 5) == ll.end(), Eq(true));
+
+  const DList<int> &ref = ll;
+  DList<int>::const_iterator it = ll.begin();
+  EXPECT_THAT(it == ref.begin(), Eq(true));
+  EXPECT_THAT(*++it, Eq(7));
+}
+TEST(LinkedListIterators, emptyList) {
+  LinkedList<int> ll;
+  EXPECT_THAT(ll.begin() == ll.end(), Eq(true));
+  EXPECT_THAT(distance(ll.cbegin(), ll.cend()), Eq(0));
+}
+
+//Splice
+TEST(LinkedListSplice, spliceBackAndFrontRelink) {
+  LinkedList<string> l1;
+  l1.push_back("c");
+  LinkedList<string> l2;
+  l2.push_back("d");
+  l2.push_back("e");
+  LinkedList<string> l3;
+  l3.push_back("a");
+  l3.push_back("b");
+  void *a = l3.front();
+
+  l1.splice_back(std::move(l2));
+  l1.splice_front(std::move(l3));
+  l1.splice_back(LinkedList<string>());
+  EXPECT_THAT(l1.to_string(), Eq("[a, b, c, d, e]"));
+  EXPECT_THAT(l1.size(), Eq(5));
+  EXPECT_THAT(l1.front(), Eq(a));
+  EXPECT_THAT(l2.empty(), Eq(true));
+  EXPECT_THAT(l3.front(), Eq(nullptr));
+
+  // Spliced-from lists are empty but usable.
+  l2.splice_front(std::move(l3));
+  l2.push_back("f");
+  EXPECT_THAT(l2.to_string(), Eq("[f]"));
+  l1.push_back("g");
+  EXPECT_THAT(l1.at(5), Eq("g"));
+}
+TEST(LinkedListSplice, spliceAfterIndex) {
+  DList<int> ll;
+  ll.push_back(1);
+  ll.push_back(4);
+  DList<int> mid;
+  mid.push_back(2);
+  mid.push_back(3);
+  DList<int> end;
+  end.push_back(5);
+
+  ll.splice_after(0, std::move(mid));
+  ll.splice_after(3, std::move(end));
+  EXPECT_THAT(ll.to_string(), Eq("[1, 2, 3, 4, 5]"));
+  EXPECT_THROW(ll.splice_after(5, DList<int>()), out_of_range);
+
+  // The prev links must be intact for O(1) pop_back and backward walks.
+  EXPECT_THAT(ll.at(3), Eq(4));
+  EXPECT_THAT(ll.pop_back(), Eq(5));
+  EXPECT_THAT(ll.pop_back(), Eq(4));
+  EXPECT_THAT(ll.pop_back(), Eq(3));
+  ll.push_back(6);
+  EXPECT_THAT(ll.to_string(), Eq("[1, 2, 6]"));
+}
+TEST(LinkedListSplice, splitAt) {
+  DList<int> ll;
+  for (int i = 0; i < 6; i++) {
+    ll.push_back(i);
+  }
+
+  DList<int> back = ll.split_at(4);
+  EXPECT_THAT(ll.to_string(), Eq("[0, 1, 2, 3]"));
+  EXPECT_THAT(back.to_string(), Eq("[4, 5]"));
+  EXPECT_THAT(back.pop_front(), Eq(4));
+  EXPECT_THAT(ll.pop_back(), Eq(3));
+
+  DList<int> all = ll.split_at(0);
+  EXPECT_THAT(ll.empty(), Eq(true));
+  EXPECT_THAT(all.to_string(), Eq("[0, 1, 2]"));
+  EXPECT_THAT(all.split_at(3).empty(), Eq(true));
+  EXPECT_THROW(all.split_at(4), out_of_range);
+
+  LinkedList<int> singly;
+  singly.push_back(1);
+  singly.push_back(2);
+  LinkedList<int> second = singly.split_at(1);
+  singly.push_back(3);
+  second.push_back(4);
+  EXPECT_THAT(singly.to_string(), Eq("[1, 3]"));
+  EXPECT_THAT(second.to_string(), Eq("[2, 4]"));
+}
+TEST(LinkedListSplice, pooledLists) {
+  LinkedList<int, NodePool<int>> l1;
+  for (int i = 0; i < 4; i++) {
+    l1.push_back(i);
+  }
+
+  // The split-off half shares the pool, so it can be spliced back in O(1).
+  LinkedList<int, NodePool<int>> half = l1.split_at(2);
+  EXPECT_THAT(half.node_allocator() == l1.node_allocator(), Eq(true));
+  l1.splice_front(std::move(half));
+  EXPECT_THAT(l1.to_string(), Eq("[2, 3, 0, 1]"));
+  EXPECT_THAT(l1.node_allocator().stats().allocations, Eq(4));
+
+  // Separate pools cannot share nodes, so the elements are moved instead.
+  LinkedList<int, NodePool<int>> other;
+  other.push_back(9);
+  l1.splice_back(std::move(other));
+  EXPECT_THAT(l1.to_string(), Eq("[2, 3, 0, 1, 9]"));
+  EXPECT_THAT(other.empty(), Eq(true));
+  EXPECT_THAT(other.node_allocator().stats().live, Eq(0));
+  EXPECT_THAT(l1.node_allocator().stats().live, Eq(5));
+}
+TEST(LinkedListFormat, writeToMatchesToString) {
+  DList<double> list;
+  list.push_back(0.5);
+  list.push_back(-1e-7);
+  list.push_back(100000000.0);
+  EXPECT_THAT(list.to_string(), Eq("[0.5, -1e-07, 1e+08]"));
+
+  ostringstream os;
+  os << "list: ";
+  list.write_to(os);
+  EXPECT_THAT(os.str(), Eq("list: [0.5, -1e-07, 1e+08]"));
+
+  LinkedList<string> words;
+  words.push_back("a");
+  words.push_back("b c");
+  string out;
+  words.write_to(out);
+  words.write_to(out);
+  EXPECT_THAT(out, Eq("[a, b c][a, b c]"));
+  EXPECT_THAT(LinkedList<int>().to_string(), Eq("[]"));
+}
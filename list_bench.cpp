@@ -0,0 +1,369 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "circvector.h"
+#include "linkedlist.h"
+#include "unrolledlist.h"
+
+using namespace std;
+
+// Throughput benchmarks for CircVector, LinkedList and UnrolledList, with
+// std::deque, std::vector and std::list baselines for every case. Each case
+// runs at sizes 10 to 10^7 (10^6 for strings), and reports items processed per
+// second.
+//
+//   ./list_bench --benchmark_filter=PushPopBack
+//   ./list_bench --benchmark_out=out.json --benchmark_out_format=json
+
+namespace {
+
+template <typename C>
+using Elem = remove_cvref_t<decltype(*declval<C &>().begin())>;
+
+// Whether `C` is one of our containers rather than a standard one.
+template <typename C>
+constexpr bool is_ours = requires(C &c) { c.remove_evens(); };
+
+template <typename T>
+T make_value(size_t i) {
+  if constexpr (is_same_v<T, string>) {
+    // Long enough to defeat the small-string optimization.
+    return string(32, static_cast<char>('a' + i % 26));
+  }
+  else {
+    return static_cast<T>(i);
+  }
+}
+
+template <typename T>
+T absent_value() {
+  if constexpr (is_same_v<T, string>) {
+    return string(32, '#');
+  }
+  else {
+    return static_cast<T>(-1);
+  }
+}
+
+// Uniform operations over our containers and the standard ones.
+
+template <typename C>
+C make_filled(size_t n) {
+  C c;
+  for (size_t i = 0; i < n; i++) {
+    c.push_back(make_value<Elem<C>>(i));
+  }
+  return c;
+}
+
+template <typename C, typename T>
+void push_front(C &c, const T &value) {
+  if constexpr (requires { c.push_front(value); }) {
+    c.push_front(value);
+  }
+  else {
+    c.insert(c.begin(), value);
+  }
+}
+
+template <typename C>
+void pop_front(C &c) {
+  if constexpr (requires { c.pop_front(); }) {
+    c.pop_front();
+  }
+  else {
+    c.erase(c.begin());
+  }
+}
+
+template <typename C>
+Elem<C> &at(C &c, size_t index) {
+  if constexpr (requires { c.at(index); }) {
+    return c.at(index);
+  }
+  else {
+    return *next(c.begin(), index);
+  }
+}
+
+template <typename C>
+size_t find_index(C &c, const Elem<C> &value) {
+  if constexpr (is_ours<C>) {
+    return c.find(value);
+  }
+  else {
+    auto it = find(c.begin(), c.end(), value);
+    return (it == c.end()) ? size_t(-1) : distance(c.begin(), it);
+  }
+}
+
+template <typename C>
+void insert_after(C &c, size_t index, const Elem<C> &value) {
+  if constexpr (is_ours<C>) {
+    c.insert_after(index, value);
+  }
+  else {
+    c.insert(next(c.begin(), index + 1), value);
+  }
+}
+
+template <typename C>
+void remove_at(C &c, size_t index) {
+  if constexpr (is_ours<C>) {
+    c.remove_at(index);
+  }
+  else {
+    c.erase(next(c.begin(), index));
+  }
+}
+
+template <typename C>
+void remove_evens(C &c) {
+  if constexpr (is_ours<C>) {
+    c.remove_evens();
+  }
+  else if constexpr (is_same_v<C, list<Elem<C>>>) {
+    for (auto it = c.begin(); it != c.end();) {
+      it = c.erase(it);
+      if (it != c.end()) {
+        ++it;
+      }
+    }
+  }
+  else {
+    size_t kept = 0;
+    for (size_t i = 1; i < c.size(); i += 2) {
+      c[kept++] = std::move(c[i]);
+    }
+    c.erase(c.begin() + kept, c.end());
+  }
+}
+
+template <typename C>
+void append(C &c, const vector<Elem<C>> &chunk) {
+  if constexpr (requires { c.append(chunk); }) {
+    c.append(chunk);
+  }
+  else if constexpr (is_ours<C>) {
+    for (const Elem<C> &value : chunk) {
+      c.push_back(value);
+    }
+  }
+  else {
+    c.insert(c.end(), chunk.begin(), chunk.end());
+  }
+}
+
+// The standard containers have no `to_string`; they get the stringstream
+// loop our containers used before `write_to`, as the baseline.
+template <typename C>
+void write_text(const C &c, string &out) {
+  if constexpr (requires { c.write_to(out); }) {
+    c.write_to(out);
+  }
+  else if constexpr (is_ours<C>) {
+    out += c.to_string();
+  }
+  else {
+    stringstream ss;
+    ss << "[";
+    for (auto it = c.begin(); it != c.end(); ++it) {
+      ss << *it;
+      if (next(it) != c.end()) {
+        ss << ", ";
+      }
+    }
+    ss << "]";
+    out += ss.str();
+  }
+}
+
+// Benchmarks. Unless noted, each iteration performs one operation (or one
+// balanced pair of operations) on a container held at size N.
+
+template <typename C>
+void BM_PushPopBack(benchmark::State &state) {
+  C c = make_filled<C>(state.range(0));
+  Elem<C> value = make_value<Elem<C>>(7);
+  for (auto _ : state) {
+    c.push_back(value);
+    c.pop_back();
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+
+template <typename C>
+void BM_PushPopFront(benchmark::State &state) {
+  C c = make_filled<C>(state.range(0));
+  Elem<C> value = make_value<Elem<C>>(7);
+  for (auto _ : state) {
+    push_front(c, value);
+    pop_front(c);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+
+template <typename C>
+void BM_At(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c = make_filled<C>(n);
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at(c, index));
+    // Stride through the container so every position gets visited.
+    index += 7919;
+    if (index >= n) {
+      index %= n;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename C>
+void BM_FindMissing(benchmark::State &state) {
+  C c = make_filled<C>(state.range(0));
+  Elem<C> missing = absent_value<Elem<C>>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(find_index(c, missing));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename C>
+void BM_InsertRemoveMiddle(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c = make_filled<C>(n);
+  Elem<C> value = make_value<Elem<C>>(7);
+  for (auto _ : state) {
+    insert_after(c, n / 2, value);
+    remove_at(c, n / 2 + 1);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+
+// Refilling is excluded from the timing, but pause/resume overhead dominates
+// at small N.
+template <typename C>
+void BM_RemoveEvens(benchmark::State &state) {
+  C prototype = make_filled<C>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c = prototype;
+    state.ResumeTiming();
+    remove_evens(c);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename C>
+void BM_Copy(benchmark::State &state) {
+  C prototype = make_filled<C>(state.range(0));
+  for (auto _ : state) {
+    C c = prototype;
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Grows a default-constructed container to N elements with push_back, so
+// every reallocation is included.
+template <typename C>
+void BM_Growth(benchmark::State &state) {
+  size_t n = state.range(0);
+  Elem<C> value = make_value<Elem<C>>(7);
+  for (auto _ : state) {
+    C c;
+    for (size_t i = 0; i < n; i++) {
+      c.push_back(value);
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Fills a default-constructed container to N elements in chunks of up to 64K,
+// the way a batch ingest path does.
+template <typename C>
+void BM_AppendChunks(benchmark::State &state) {
+  size_t n = state.range(0);
+  vector<Elem<C>> chunk(min<size_t>(n, 65536), make_value<Elem<C>>(7));
+  size_t chunks = (n + chunk.size() - 1) / chunk.size();
+  for (auto _ : state) {
+    C c;
+    for (size_t i = 0; i < chunks; i++) {
+      append(c, chunk);
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * chunks * chunk.size());
+}
+
+// Formats the whole container into a reused string.
+template <typename C>
+void BM_ToString(benchmark::State &state) {
+  C c = make_filled<C>(state.range(0));
+  string out;
+  for (auto _ : state) {
+    out.clear();
+    write_text(c, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void IntSizes(benchmark::internal::Benchmark *b) {
+  b->RangeMultiplier(10)->Range(10, 10'000'000);
+}
+
+void StringSizes(benchmark::internal::Benchmark *b) {
+  b->RangeMultiplier(10)->Range(10, 1'000'000);
+}
+
+// Short-lived queues of a few elements, where an inline buffer saves the
+// allocation.
+void ShortSizes(benchmark::internal::Benchmark *b) {
+  b->Arg(0)->Arg(4)->Arg(16);
+}
+
+using SmallInts = SmallCircVector<int, 16>;
+
+}  // namespace
+
+#define CONTAINER_BENCHMARKS(BM, T, SIZES)                   \
+  BENCHMARK_TEMPLATE(BM, CircVector<T>)->Apply(SIZES);       \
+  BENCHMARK_TEMPLATE(BM, LinkedList<T>)->Apply(SIZES);       \
+  BENCHMARK_TEMPLATE(BM, DList<T>)->Apply(SIZES);            \
+  BENCHMARK_TEMPLATE(BM, UnrolledList<T>)->Apply(SIZES);     \
+  BENCHMARK_TEMPLATE(BM, deque<T>)->Apply(SIZES);            \
+  BENCHMARK_TEMPLATE(BM, vector<T>)->Apply(SIZES);           \
+  BENCHMARK_TEMPLATE(BM, list<T>)->Apply(SIZES)
+
+#define ALL_BENCHMARKS(T, SIZES)                          \
+  CONTAINER_BENCHMARKS(BM_PushPopBack, T, SIZES);         \
+  CONTAINER_BENCHMARKS(BM_PushPopFront, T, SIZES);        \
+  CONTAINER_BENCHMARKS(BM_At, T, SIZES);                  \
+  CONTAINER_BENCHMARKS(BM_FindMissing, T, SIZES);         \
+  CONTAINER_BENCHMARKS(BM_InsertRemoveMiddle, T, SIZES);  \
+  CONTAINER_BENCHMARKS(BM_RemoveEvens, T, SIZES);         \
+  CONTAINER_BENCHMARKS(BM_Copy, T, SIZES);                \
+  CONTAINER_BENCHMARKS(BM_Growth, T, SIZES);              \
+  CONTAINER_BENCHMARKS(BM_AppendChunks, T, SIZES);       \
+  CONTAINER_BENCHMARKS(BM_ToString, T, SIZES)
+
+ALL_BENCHMARKS(int, IntSizes);
+ALL_BENCHMARKS(string, StringSizes);
+
+BENCHMARK_TEMPLATE(BM_Growth, CircVector<int>)->Apply(ShortSizes);
+BENCHMARK_TEMPLATE(BM_Growth, SmallInts)->Apply(ShortSizes);
+
+BENCHMARK_MAIN();
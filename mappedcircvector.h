@@ -0,0 +1,449 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "simdscan.h"
+
+using namespace std;
+
+/**
+ * A ring buffer of trivially copyable `T` that lives in a memory-mapped file,
+ * so it survives restarts. The file holds a small header (`capacity`, and
+ * `front_idx` and `vec_size` packed into one word) followed by the slots,
+ * and both are used in place: reopening a file maps it and is ready
+ * immediately, however many elements it holds.
+ *
+ * Changes reach the file through the shared mapping, and the kernel writes
+ * them back on its own schedule. Call `sync()` to make everything up to that
+ * point durable. Every operation writes its slots first and then publishes
+ * the new `front_idx` and `vec_size` together with a single aligned 64-bit
+ * store, so if the process dies midway the file holds the ring from just
+ * before or just after the operation, never a mix; after a machine crash,
+ * only the state at the last `sync()` is guaranteed.
+ *
+ * The capacity is always a power of two, at most 2^31 so that both halves
+ * of the packed word fit in 32 bits. Growing doubles it with
+ * `ftruncate`, maps the larger file, and moves the wrapped-around part of
+ * the ring into the new upper half, so nothing else is copied.
+ *
+ * A file can be open in one `MappedCircVector` at a time; the file is locked
+ * with `flock` while it is open. Files are not portable between machines
+ * with different `T` layouts or byte orders.
+ */
+template <typename T>
+  requires is_trivially_copyable_v<T>
+class MappedCircVector {
+ private:
+  struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t elem_size;
+    uint64_t capacity;
+    // `front_idx` in the low 32 bits, `vec_size` in the high 32 bits.
+    alignas(8) uint64_t ring;
+  };
+
+  // Where the ring currently starts, and how many elements it holds.
+  struct Ring {
+    size_t front_idx;
+    size_t vec_size;
+  };
+
+  static constexpr uint64_t file_magic = 0x314352494350414dULL;  // "MAPCIRC1"
+  // Version 1 kept `front_idx` and `vec_size` in separate words.
+  static constexpr uint32_t file_version = 2;
+  static constexpr size_t max_capacity = size_t(1) << 31;
+  // The slots start on their own cache line, after the header.
+  static constexpr size_t data_offset = 64;
+  static_assert(sizeof(Header) <= data_offset && alignof(T) <= data_offset);
+
+  int fd = -1;
+  Header *header = nullptr;
+  T *data = nullptr;
+  size_t mapped_bytes = 0;
+
+  [[noreturn]] static void throw_errno(const string &what) {
+    throw system_error(errno, generic_category(), what);
+  }
+
+  static size_t file_bytes(size_t capacity) {
+    return data_offset + capacity * sizeof(T);
+  }
+
+  size_t wrap(size_t i) const {
+    return i & (header->capacity - 1);
+  }
+
+  Ring ring() const {
+    uint64_t word = atomic_ref<uint64_t>(header->ring).load(
+        memory_order_relaxed);
+    return {size_t(word & 0xffffffff), size_t(word >> 32)};
+  }
+
+  /**
+   * Publishes a new `front_idx` and `vec_size` with one store, ordered after
+   * the slot writes that precede it.
+   */
+  void commit(size_t front_idx, size_t vec_size) {
+    atomic_ref<uint64_t>(header->ring)
+        .store(uint64_t(front_idx) | uint64_t(vec_size) << 32,
+               memory_order_release);
+  }
+
+  /**
+   * Maps the first `bytes` of the file, replacing any current mapping. The
+   * current mapping is only dropped once the new one is in place.
+   */
+  void map(size_t bytes) {
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      throw_errno("mmap");
+    }
+    if (header != nullptr) {
+      munmap(header, mapped_bytes);
+    }
+    header = static_cast<Header *>(p);
+    data = reinterpret_cast<T *>(static_cast<char *>(p) + data_offset);
+    mapped_bytes = bytes;
+  }
+
+  /**
+   * Unmaps and closes the file, if open.
+   */
+  void release() {
+    if (header != nullptr) {
+      munmap(header, mapped_bytes);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    fd = -1;
+    header = nullptr;
+    data = nullptr;
+    mapped_bytes = 0;
+  }
+
+  /**
+   * Sets up a freshly created, empty file. The magic number is written
+   * last, so a file that is sized but not yet stamped (because the process
+   * died in between) is recognised by `unfinished` and set up again.
+   */
+  void create(size_t capacity) {
+    if (capacity > max_capacity) {
+      throw length_error("MappedCircVector capacity is limited to 2^31");
+    }
+    capacity = bit_ceil(max<size_t>(capacity, 1));
+    if (ftruncate(fd, file_bytes(capacity)) != 0) {
+      throw_errno("ftruncate");
+    }
+    map(file_bytes(capacity));
+    header->version = file_version;
+    header->elem_size = sizeof(T);
+    header->capacity = capacity;
+    header->ring = 0;
+    atomic_ref<uint64_t>(header->magic)
+        .store(file_magic, memory_order_release);
+  }
+
+  /**
+   * Returns whether the file, of `size` bytes, was left behind by a `create`
+   * that sized it but never wrote the magic number. Such a file holds no
+   * elements.
+   */
+  bool unfinished(size_t size) const {
+    if (size < data_offset || (size - data_offset) % sizeof(T) != 0 ||
+        !has_single_bit((size - data_offset) / sizeof(T))) {
+      return false;
+    }
+    uint64_t magic;
+    if (pread(fd, &magic, sizeof(magic), 0) != sizeof(magic)) {
+      throw_errno("pread");
+    }
+    return magic == 0;
+  }
+
+  /**
+   * Maps an existing file of `size` bytes and checks that it holds a ring
+   * of `T`.
+   */
+  void attach(size_t size) {
+    if (size < data_offset) {
+      throw runtime_error("Not a MappedCircVector file");
+    }
+    map(size);
+    const Header &h = *header;
+    if (h.magic != file_magic || h.version != file_version) {
+      throw runtime_error("Not a MappedCircVector file");
+    }
+    if (h.elem_size != sizeof(T)) {
+      throw runtime_error("MappedCircVector file holds a different type");
+    }
+    Ring r = ring();
+    if (!has_single_bit(h.capacity) || h.capacity > max_capacity ||
+        r.vec_size > h.capacity || r.front_idx >= h.capacity ||
+        size < file_bytes(h.capacity)) {
+      throw runtime_error("MappedCircVector file is corrupt");
+    }
+  }
+
+  /**
+   * Doubles the capacity. If the ring wraps, the wrapped-around elements
+   * at the start of the buffer are moved to just past the old end, which
+   * keeps them in order behind the others.
+   */
+  void grow() {
+    size_t old_capacity = header->capacity;
+    size_t new_capacity = old_capacity * 2;
+    if (new_capacity > max_capacity) {
+      throw length_error("MappedCircVector capacity is limited to 2^31");
+    }
+    if (ftruncate(fd, file_bytes(new_capacity)) != 0) {
+      throw_errno("ftruncate");
+    }
+    map(file_bytes(new_capacity));
+    Ring r = ring();
+    size_t end = r.front_idx + r.vec_size;
+    if (end > old_capacity) {
+      memcpy(data + old_capacity, data, (end - old_capacity) * sizeof(T));
+    }
+    // The old slots are untouched, so the ring is valid under either
+    // capacity until this store switches over.
+    atomic_ref<uint64_t>(header->capacity)
+        .store(new_capacity, memory_order_release);
+  }
+
+ public:
+  /**
+   * Opens the ring stored at `path`, creating it with room for `capacity`
+   * elements (rounded up to a power of two) if the file does not exist, is
+   * empty, or was being created when its process died. An existing ring is
+   * used as it is, and `capacity` is ignored.
+   *
+   * Throws `system_error` if the file cannot be opened, locked or mapped,
+   * `runtime_error` if it is not a ring of this `T`, and `length_error` if
+   * a new file would need more than 2^31 slots.
+   */
+  explicit MappedCircVector(const string &path, size_t capacity = 16) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw_errno("open " + path);
+    }
+    try {
+      if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        throw_errno("flock " + path);
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+        throw_errno("fstat " + path);
+      }
+      if (st.st_size == 0 || unfinished(st.st_size)) {
+        create(capacity);
+      }
+      else {
+        attach(st.st_size);
+      }
+    }
+    catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  MappedCircVector(const MappedCircVector &) = delete;
+  MappedCircVector &operator=(const MappedCircVector &) = delete;
+
+  /**
+   * Move constructor. Takes over the mapping of `other`, which is left
+   * closed.
+   */
+  MappedCircVector(MappedCircVector &&other) noexcept
+      : fd(exchange(other.fd, -1)),
+        header(exchange(other.header, nullptr)),
+        data(exchange(other.data, nullptr)),
+        mapped_bytes(exchange(other.mapped_bytes, 0)) {
+  }
+
+  /**
+   * Unmaps and closes the file. Changes not yet written back by the kernel
+   * still reach the file, but are only guaranteed durable after `sync()`.
+   */
+  ~MappedCircVector() {
+    release();
+  }
+
+  /**
+   * Returns whether the ring is empty.
+   */
+  bool empty() const {
+    return ring().vec_size == 0;
+  }
+
+  /**
+   * Returns the number of elements in the ring.
+   */
+  size_t size() const {
+    return ring().vec_size;
+  }
+
+  /**
+   * Returns the number of slots in the file.
+   */
+  size_t get_capacity() const {
+    return header->capacity;
+  }
+
+  /**
+   * Adds the given `T` to the back, growing the file if it is full.
+   */
+  void push_back(const T &elem) {
+    if (size() == header->capacity) {
+      grow();
+    }
+    Ring r = ring();
+    data[wrap(r.front_idx + r.vec_size)] = elem;
+    commit(r.front_idx, r.vec_size + 1);
+  }
+
+  /**
+   * Adds the given `T` to the front, growing the file if it is full.
+   */
+  void push_front(const T &elem) {
+    if (size() == header->capacity) {
+      grow();
+    }
+    Ring r = ring();
+    size_t slot = wrap(r.front_idx + header->capacity - 1);
+    data[slot] = elem;
+    commit(slot, r.vec_size + 1);
+  }
+
+  /**
+   * Removes and returns the element at the front.
+   *
+   * If the ring is empty, throws a `runtime_error`.
+   */
+  T pop_front() {
+    Ring r = ring();
+    if (r.vec_size == 0) {
+      throw runtime_error("Vector is empty");
+    }
+    T value = data[r.front_idx];
+    commit(wrap(r.front_idx + 1), r.vec_size - 1);
+    return value;
+  }
+
+  /**
+   * Removes and returns the element at the back.
+   *
+   * If the ring is empty, throws a `runtime_error`.
+   */
+  T pop_back() {
+    Ring r = ring();
+    if (r.vec_size == 0) {
+      throw runtime_error("Vector is empty");
+    }
+    T value = data[wrap(r.front_idx + r.vec_size - 1)];
+    commit(r.front_idx, r.vec_size - 1);
+    return value;
+  }
+
+  /**
+   * Removes every element. The file keeps its size.
+   */
+  void clear() {
+    commit(0, 0);
+  }
+
+  /**
+   * Returns the element at the given index.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  T &at(size_t index) const {
+    Ring r = ring();
+    if (index >= r.vec_size) {
+      throw out_of_range("Index is out of range");
+    }
+    return data[wrap(r.front_idx + index)];
+  }
+
+  /**
+   * Returns the index of the first element equal to `target`, or "-1".
+   * Vectorized for arithmetic `T`, like `CircVector::find`.
+   */
+  size_t find(const T &target) const {
+    auto [first, second] = as_spans();
+    for (size_t offset = 0; span<const T> run : {first, second}) {
+      size_t i;
+      if constexpr (simd_scannable<T>) {
+        i = simd_find(run.data(), run.size(), target);
+      }
+      else {
+        i = std::find(run.begin(), run.end(), target) - run.begin();
+      }
+      if (i < run.size()) {
+        return offset + i;
+      }
+      offset += run.size();
+    }
+    return -1;
+  }
+
+  /**
+   * Returns the contents as two contiguous runs of the mapping, in logical
+   * order, like `CircVector::as_spans`. The spans are invalidated by
+   * anything that grows the file.
+   */
+  pair<span<T>, span<T>> as_spans() const {
+    Ring r = ring();
+    size_t first = min<size_t>(r.vec_size, header->capacity - r.front_idx);
+    return {span<T>(data + r.front_idx, first),
+            span<T>(data, r.vec_size - first)};
+  }
+
+  /**
+   * Converts the ring to a string. Formatted like `[0, 1, 2, 3, 4]`.
+   */
+  string to_string() const {
+    stringstream ss;
+    ss << "[";
+    Ring r = ring();
+    for (size_t i = 0; i < r.vec_size; i++) {
+      ss << data[wrap(r.front_idx + i)];
+      if (i + 1 < r.vec_size) {
+        ss << ", ";
+      }
+    }
+    ss << "]";
+    return ss.str();
+  }
+
+  /**
+   * Blocks until every change so far is written to the file (`msync` with
+   * `MS_SYNC`). Throws `system_error` on failure.
+   */
+  void sync() {
+    if (msync(header, mapped_bytes, MS_SYNC) != 0) {
+      throw_errno("msync");
+    }
+  }
+};
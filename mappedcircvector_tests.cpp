@@ -0,0 +1,172 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "mappedcircvector.h"
+
+using namespace std;
+using namespace testing;
+
+namespace {
+
+struct Record {
+  uint64_t id;
+  double price;
+};
+
+// A fresh file path in the test temp directory, removed on destruction.
+struct TempPath {
+  string path;
+
+  explicit TempPath(const string &name) : path(TempDir() + name) {
+    remove(path.c_str());
+  }
+
+  ~TempPath() {
+    remove(path.c_str());
+  }
+};
+
+}  // namespace
+
+TEST(MappedCircVector, createPushPop) {
+  TempPath file("mcv_basic.ring");
+  MappedCircVector<int> v(file.path, 4);
+
+  EXPECT_THAT(v.empty(), Eq(true));
+  EXPECT_THAT(v.get_capacity(), Eq(4));
+  v.push_back(2);
+  v.push_back(3);
+  v.push_front(1);
+  v.push_front(0);
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3]"));
+  EXPECT_THAT(v.as_spans().second.empty(), Eq(false));
+
+  // Growing while wrapped keeps the order.
+  v.push_back(4);
+  EXPECT_THAT(v.get_capacity(), Eq(8));
+  EXPECT_THAT(v.to_string(), Eq("[0, 1, 2, 3, 4]"));
+  EXPECT_THAT(v.find(3), Eq(3));
+  EXPECT_THAT(v.find(9), Eq(size_t(-1)));
+
+  EXPECT_THAT(v.pop_front(), Eq(0));
+  EXPECT_THAT(v.pop_back(), Eq(4));
+  EXPECT_THAT(v.at(0), Eq(1));
+  EXPECT_THROW(v.at(3), out_of_range);
+  v.clear();
+  EXPECT_THROW(v.pop_back(), runtime_error);
+}
+TEST(MappedCircVector, reopenKeepsContents) {
+  TempPath file("mcv_reopen.ring");
+  {
+    MappedCircVector<Record> v(file.path, 2);
+    for (uint64_t i = 0; i < 100; i++) {
+      v.push_back({i, i * 1.5});
+    }
+    for (int i = 0; i < 10; i++) {
+      v.pop_front();
+    }
+    v.push_front({999, 0.25});
+    v.sync();
+  }
+
+  MappedCircVector<Record> v(file.path, 2);
+  EXPECT_THAT(v.size(), Eq(91));
+  EXPECT_THAT(v.get_capacity(), Eq(128));
+  EXPECT_THAT(v.at(0).id, Eq(999));
+  EXPECT_THAT(v.at(1).id, Eq(10));
+  EXPECT_THAT(v.at(90).price, Eq(99 * 1.5));
+
+  MappedCircVector<Record> moved(std::move(v));
+  EXPECT_THAT(moved.pop_back().id, Eq(99));
+}
+TEST(MappedCircVector, rejectsForeignAndLockedFiles) {
+  TempPath file("mcv_checks.ring");
+  {
+    MappedCircVector<int32_t> v(file.path);
+    v.push_back(1);
+
+    // Already open.
+    EXPECT_THROW(MappedCircVector<int32_t>{file.path}, system_error);
+  }
+  EXPECT_THROW(MappedCircVector<int64_t>{file.path}, runtime_error);
+
+  TempPath junk("mcv_junk.ring");
+  ofstream(junk.path) << "definitely not a ring buffer, but long enough to "
+                         "cover the whole header";
+  EXPECT_THROW(MappedCircVector<int32_t>{junk.path}, runtime_error);
+
+  EXPECT_THROW(MappedCircVector<int32_t>{"/nonexistent/dir/x.ring"},
+               system_error);
+}
+TEST(MappedCircVector, recreatesFileSizedBeforeItsHeader) {
+  // What `create` leaves if it dies between `ftruncate` and the header.
+  TempPath file("mcv_unfinished.ring");
+  ofstream(file.path).close();
+  ASSERT_THAT(truncate(file.path.c_str(), 64 + 8 * sizeof(int)), Eq(0));
+  {
+    MappedCircVector<int> v(file.path, 4);
+    EXPECT_THAT(v.empty(), Eq(true));
+    EXPECT_THAT(v.get_capacity(), Eq(4));
+    v.push_back(7);
+  }
+  MappedCircVector<int> v(file.path, 4);
+  EXPECT_THAT(v.to_string(), Eq("[7]"));
+
+  // Zeros that no `create` could have left are still rejected.
+  TempPath odd("mcv_odd.ring");
+  ofstream(odd.path).close();
+  ASSERT_THAT(truncate(odd.path.c_str(), 64 + 3 * sizeof(int)), Eq(0));
+  EXPECT_THROW(MappedCircVector<int>{odd.path}, runtime_error);
+}
+TEST(MappedCircVector, survivesKillMidOperation) {
+  TempPath file("mcv_kill.ring");
+  for (int round = 0; round < 3; round++) {
+    int ready[2];
+    ASSERT_THAT(pipe(ready), Eq(0));
+    pid_t child = fork();
+    ASSERT_THAT(child, Ge(0));
+    if (child == 0) {
+      // Pushes a rising counter at the front and trims the back, until
+      // killed at an arbitrary point.
+      MappedCircVector<uint64_t> v(file.path, 4);
+      uint64_t next = v.empty() ? 0 : v.at(0) + 1;
+      char byte = 1;
+      if (write(ready[1], &byte, 1) != 1) {
+        _exit(1);
+      }
+      while (true) {
+        v.push_front(next++);
+        if (v.size() > 50) {
+          v.pop_back();
+          v.pop_back();
+        }
+      }
+    }
+    char byte;
+    ASSERT_THAT(read(ready[0], &byte, 1), Eq(1));
+    close(ready[0]);
+    close(ready[1]);
+    this_thread::sleep_for(chrono::milliseconds(10 + 20 * round));
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+
+    // Whatever the child was doing, the ring is a run of consecutive values.
+    MappedCircVector<uint64_t> v(file.path);
+    ASSERT_THAT(v.size(), Le(51));
+    for (size_t i = 1; i < v.size(); i++) {
+      ASSERT_THAT(v.at(i), Eq(v.at(0) - i));
+    }
+  }
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+ * Wait strategies for `MpmcRing`'s blocking `push`/`pop`. Each one says what
+ * a thread does while the ring is full (producers) or empty (consumers):
+ * `wait(word, old)` is called with the slot sequence number the thread is
+ * waiting on and the value it last saw, and `notify(word)` is called after
+ * every change to a sequence number.
+ */
+
+/**
+ * Busy-waits with a CPU pause hint. Lowest latency, but burns a core per
+ * waiting thread; only suitable when every thread has a core of its own.
+ */
+struct SpinWait {
+  template <typename W>
+  static void wait(const atomic<W> &, W) {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  template <typename W>
+  static void notify(atomic<W> &) {
+  }
+};
+
+/**
+ * Gives up the rest of the time slice between attempts.
+ */
+struct YieldWait {
+  template <typename W>
+  static void wait(const atomic<W> &, W) {
+    this_thread::yield();
+  }
+
+  template <typename W>
+  static void notify(atomic<W> &) {
+  }
+};
+
+/**
+ * Sleeps in the kernel (a futex on Linux) until the awaited slot changes.
+ * Waiting threads use no CPU, at the cost of a wake-up call on every push and
+ * pop.
+ */
+struct BlockingWait {
+  template <typename W>
+  static void wait(const atomic<W> &word, W old) {
+    word.wait(old, memory_order_acquire);
+  }
+
+  template <typename W>
+  static void notify(atomic<W> &word) {
+    word.notify_all();
+  }
+};
+
+/**
+ * Bounded multi-producer/multi-consumer queue on a power-of-two ring, using
+ * a sequence number per slot (Vyukov's scheme).
+ *
+ * Each slot's sequence number says whose turn it is: a producer claiming
+ * position `pos` may fill the slot when its sequence equals `pos`, and
+ * publishes it by storing `pos + 1`; a consumer may empty it when the
+ * sequence equals `pos + 1`, and hands it back by storing `pos + capacity`.
+ * Producers and consumers only contend on their own position counter, which
+ * each live on a separate cache line, as does every slot.
+ *
+ * `try_push`/`try_pop` never wait. `push`/`pop` wait according to `Wait`
+ * (`SpinWait`, `YieldWait` or `BlockingWait`) while the ring is full or
+ * empty.
+ */
+template <typename T, typename Wait = YieldWait>
+class MpmcRing {
+ private:
+  static constexpr size_t cache_line = 64;
+
+  struct alignas(cache_line) Slot {
+    atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *elem() {
+      return reinterpret_cast<T *>(storage);
+    }
+  };
+
+  // Read-only after construction.
+  alignas(cache_line) Slot *slots;
+  size_t capacity;
+  size_t mask;
+
+  alignas(cache_line) atomic<size_t> enqueue_pos;
+  alignas(cache_line) atomic<size_t> dequeue_pos;
+
+  /**
+   * Constructs an element from `args` and queues it. Returns false if the
+   * ring is full and `Block` is false; otherwise waits for a free slot.
+   *
+   * Once a position is claimed its slot must be published, or the consumer
+   * of that position (and every producer a lap later) waits forever. So an
+   * element whose constructor may throw is built before claiming and then
+   * moved in, which cannot throw.
+   */
+  template <bool Block, typename... Args>
+  bool enqueue(Args &&...args) {
+    if constexpr (is_nothrow_constructible_v<T, Args...>) {
+      return claim_and_construct<Block>(std::forward<Args>(args)...);
+    }
+    else {
+      static_assert(is_nothrow_move_constructible_v<T>,
+                    "MpmcRing elements built by a throwing constructor "
+                    "need a noexcept move constructor");
+      T elem(std::forward<Args>(args)...);
+      return claim_and_construct<Block>(std::move(elem));
+    }
+  }
+
+  /**
+   * Claims the next producer position and constructs an element there from
+   * `args`, which must not throw.
+   */
+  template <bool Block, typename... Args>
+  bool claim_and_construct(Args &&...args) {
+    size_t pos = enqueue_pos.load(memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots[pos & mask];
+      size_t seq = slot.sequence.load(memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                              memory_order_relaxed)) {
+          construct_at(slot.elem(), std::forward<Args>(args)...);
+          slot.sequence.store(pos + 1, memory_order_release);
+          Wait::notify(slot.sequence);
+          return true;
+        }
+      }
+      else if (diff < 0) {
+        // The slot still holds the element from one lap ago: full.
+        if constexpr (!Block) {
+          return false;
+        }
+        Wait::wait(slot.sequence, seq);
+        pos = enqueue_pos.load(memory_order_relaxed);
+      }
+      else {
+        pos = enqueue_pos.load(memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Claims the next consumer position and moves its element into `out`.
+   * Returns false if the ring is empty and `Block` is false; otherwise waits
+   * for an element.
+   */
+  template <bool Block>
+  bool dequeue(T &out) {
+    size_t pos = dequeue_pos.load(memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots[pos & mask];
+      size_t seq = slot.sequence.load(memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                              memory_order_relaxed)) {
+          out = std::move(*slot.elem());
+          destroy_at(slot.elem());
+          slot.sequence.store(pos + capacity, memory_order_release);
+          Wait::notify(slot.sequence);
+          return true;
+        }
+      }
+      else if (diff < 0) {
+        // Nothing has been published at this position yet: empty.
+        if constexpr (!Block) {
+          return false;
+        }
+        Wait::wait(slot.sequence, seq);
+        pos = dequeue_pos.load(memory_order_relaxed);
+      }
+      else {
+        pos = dequeue_pos.load(memory_order_relaxed);
+      }
+    }
+  }
+
+ public:
+  /**
+   * Creates an empty ring holding at least `capacity` elements (rounded up
+   * to a power of two). Throws `invalid_argument` if `capacity` is less
+   * than 2.
+   */
+  explicit MpmcRing(size_t capacity) {
+    if (capacity < 2) {
+      throw invalid_argument("Capacity must be > 1");
+    }
+    this->capacity = bit_ceil(capacity);
+    mask = this->capacity - 1;
+    slots = static_cast<Slot *>(::operator new(this->capacity * sizeof(Slot),
+                                               align_val_t(alignof(Slot))));
+    for (size_t i = 0; i < this->capacity; i++) {
+      construct_at(&slots[i].sequence, i);
+    }
+    enqueue_pos.store(0, memory_order_relaxed);
+    dequeue_pos.store(0, memory_order_relaxed);
+  }
+
+  MpmcRing(const MpmcRing &other) = delete;
+  MpmcRing &operator=(const MpmcRing &other) = delete;
+
+  /**
+   * Destructor. Destroys any elements still queued. No thread may be using
+   * the ring.
+   */
+  ~MpmcRing() {
+    size_t end = enqueue_pos.load(memory_order_relaxed);
+    for (size_t pos = dequeue_pos.load(memory_order_relaxed); pos != end;
+         pos++) {
+      destroy_at(slots[pos & mask].elem());
+    }
+    for (size_t i = 0; i < capacity; i++) {
+      destroy_at(&slots[i].sequence);
+    }
+    ::operator delete(slots, align_val_t(alignof(Slot)));
+  }
+
+  /**
+   * Constructs an element from `args` at the back. Returns false, without
+   * queuing anything, if the ring is full. If the constructor throws, the
+   * exception propagates and the ring is unchanged.
+   */
+  template <typename... Args>
+  bool try_emplace(Args &&...args) {
+    return enqueue<false>(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Copies `elem` onto the back. Returns false if the ring is full.
+   */
+  bool try_push(const T &elem) {
+    return enqueue<false>(elem);
+  }
+
+  /**
+   * Moves `elem` onto the back. Returns false, leaving `elem` untouched, if
+   * the ring is full.
+   */
+  bool try_push(T &&elem) {
+    return enqueue<false>(std::move(elem));
+  }
+
+  /**
+   * Constructs an element from `args` at the back, waiting while the ring
+   * is full.
+   */
+  template <typename... Args>
+  void emplace(Args &&...args) {
+    enqueue<true>(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Copies `elem` onto the back, waiting while the ring is full.
+   */
+  void push(const T &elem) {
+    enqueue<true>(elem);
+  }
+
+  /**
+   * Moves `elem` onto the back, waiting while the ring is full.
+   */
+  void push(T &&elem) {
+    enqueue<true>(std::move(elem));
+  }
+
+  /**
+   * Moves the front element into `out` and removes it. Returns false,
+   * leaving `out` untouched, if the ring is empty.
+   */
+  bool try_pop(T &out) {
+    return dequeue<false>(out);
+  }
+
+  /**
+   * Removes and returns the front element, waiting while the ring is empty.
+   * Requires `T` to be default-constructible; use `pop(T&)` otherwise.
+   */
+  T pop() {
+    T out;
+    dequeue<true>(out);
+    return out;
+  }
+
+  /**
+   * Moves the front element into `out` and removes it, waiting while the
+   * ring is empty.
+   */
+  void pop(T &out) {
+    dequeue<true>(out);
+  }
+
+  /**
+   * Returns the number of queued elements. Only a snapshot while other
+   * threads are pushing or popping; may briefly count elements that are
+   * claimed but not yet published.
+   */
+  size_t size() const {
+    size_t tail = dequeue_pos.load(memory_order_acquire);
+    size_t head = enqueue_pos.load(memory_order_acquire);
+    return (head > tail) ? head - tail : 0;
+  }
+
+  /**
+   * Returns whether the ring is empty, with the same caveat as `size()`.
+   */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * Returns the number of slots in the ring.
+   */
+  size_t get_capacity() const {
+    return capacity;
+  }
+};
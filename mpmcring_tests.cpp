@@ -0,0 +1,166 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpmcring.h"
+
+using namespace std;
+using namespace testing;
+
+TEST(MpmcRingCore, pushPopInOrder) {
+  MpmcRing<int> ring(4);
+
+  EXPECT_THAT(ring.empty(), Eq(true));
+  EXPECT_THAT(ring.try_push(1), Eq(true));
+  EXPECT_THAT(ring.try_push(2), Eq(true));
+  EXPECT_THAT(ring.size(), Eq(2));
+
+  int out = 0;
+  EXPECT_THAT(ring.try_pop(out), Eq(true));
+  EXPECT_THAT(out, Eq(1));
+  EXPECT_THAT(ring.pop(), Eq(2));
+  EXPECT_THAT(ring.try_pop(out), Eq(false));
+  EXPECT_THAT(out, Eq(1));
+}
+TEST(MpmcRingCore, fullAndWrap) {
+  MpmcRing<int> ring(3);
+  EXPECT_THAT(ring.get_capacity(), Eq(4));
+  EXPECT_THROW(MpmcRing<int>(1), invalid_argument);
+
+  int out = 0;
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 4; i++) {
+      EXPECT_THAT(ring.try_push(round * 10 + i), Eq(true));
+    }
+    EXPECT_THAT(ring.try_push(99), Eq(false));
+    for (int i = 0; i < 4; i++) {
+      ring.pop(out);
+      EXPECT_THAT(out, Eq(round * 10 + i));
+    }
+  }
+}
+TEST(MpmcRingCore, moveOnlyAndLeftovers) {
+  MpmcRing<unique_ptr<string>, BlockingWait> ring(2);
+  EXPECT_THAT(ring.try_emplace(new string("a")), Eq(true));
+  ring.push(make_unique<string>("b"));
+
+  unique_ptr<string> rejected = make_unique<string>("c");
+  EXPECT_THAT(ring.try_push(std::move(rejected)), Eq(false));
+  EXPECT_THAT(*rejected, Eq("c"));
+
+  EXPECT_THAT(*ring.pop(), Eq("a"));
+  // "b" is destroyed with the ring.
+}
+TEST(MpmcRingCore, throwingConstructorLeavesRingUsable) {
+  struct Picky {
+    int value;
+
+    explicit Picky(int value) : value(value) {
+      if (value < 0) {
+        throw invalid_argument("negative");
+      }
+    }
+    Picky(Picky &&other) noexcept = default;
+    Picky &operator=(Picky &&other) noexcept = default;
+  };
+
+  MpmcRing<Picky> ring(2);
+  EXPECT_THROW(ring.try_emplace(-1), invalid_argument);
+  EXPECT_THROW(ring.emplace(-2), invalid_argument);
+  EXPECT_THAT(ring.empty(), Eq(true));
+
+  EXPECT_THAT(ring.try_emplace(1), Eq(true));
+  ring.emplace(2);
+  EXPECT_THAT(ring.try_emplace(3), Eq(false));
+
+  Picky out(0);
+  EXPECT_THAT(ring.try_pop(out), Eq(true));
+  EXPECT_THAT(out.value, Eq(1));
+  EXPECT_THAT(ring.try_pop(out), Eq(true));
+  EXPECT_THAT(out.value, Eq(2));
+  EXPECT_THAT(ring.try_pop(out), Eq(false));
+}
+
+namespace {
+
+// Runs `producers` threads each pushing `per_producer` tagged values through
+// a small ring to `consumers` threads, and checks that every value arrives
+// exactly once and each producer's values arrive in order at each consumer.
+template <typename Wait>
+void check_fan_in_fan_out(int producers, int consumers, int per_producer) {
+  MpmcRing<long, Wait> ring(8);
+  const long total = static_cast<long>(producers) * per_producer;
+  atomic<long> received(0);
+  atomic<long> sum(0);
+  atomic<bool> ordered(true);
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p] {
+      for (long i = 0; i < per_producer; i++) {
+        ring.push(p * total + i);
+      }
+    });
+  }
+  for (int c = 0; c < consumers; c++) {
+    threads.emplace_back([&] {
+      vector<long> last(producers, -1);
+      long local_sum = 0;
+      for (;;) {
+        long claimed = received.fetch_add(1);
+        if (claimed >= total) {
+          break;
+        }
+        long value = ring.pop();
+        long p = value / total;
+        long i = value % total;
+        if (i <= last[p]) {
+          ordered = false;
+        }
+        last[p] = i;
+        local_sum += i;
+      }
+      sum += local_sum;
+    });
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  EXPECT_THAT(ordered.load(), Eq(true));
+  EXPECT_THAT(sum.load(),
+              Eq(static_cast<long>(producers) * per_producer *
+                 (per_producer - 1) / 2));
+  EXPECT_THAT(ring.empty(), Eq(true));
+}
+
+}  // namespace
+
+TEST(MpmcRingThreads, spinWait) {
+  check_fan_in_fan_out<SpinWait>(2, 2, 100);
+}
+TEST(MpmcRingThreads, yieldWait) {
+  check_fan_in_fan_out<YieldWait>(4, 3, 10000);
+}
+TEST(MpmcRingThreads, blockingWait) {
+  check_fan_in_fan_out<BlockingWait>(3, 4, 10000);
+}
+TEST(MpmcRingThreads, blockingPopWaitsForPush) {
+  MpmcRing<int, BlockingWait> ring(2);
+  atomic<bool> popped(false);
+  thread consumer([&] {
+    EXPECT_THAT(ring.pop(), Eq(42));
+    popped = true;
+  });
+  this_thread::sleep_for(chrono::milliseconds(20));
+  EXPECT_THAT(popped.load(), Eq(false));
+  ring.push(42);
+  consumer.join();
+  EXPECT_THAT(popped.load(), Eq(true));
+}
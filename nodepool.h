@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Allocation counters reported by `NodePool::stats()`.
+ */
+struct NodePoolStats {
+  // Single-object requests served by the pool.
+  size_t allocations = 0;
+  // Requests served from the free list rather than fresh slab space.
+  size_t reuses = 0;
+  // Calls made to the global `operator new` (slabs plus array requests).
+  size_t heap_allocations = 0;
+  // Slabs currently held by the pool.
+  size_t slabs = 0;
+  // Objects currently handed out and not yet returned.
+  size_t live = 0;
+};
+
+/**
+ * The state behind a `NodePool` and all of its copies and rebound copies:
+ * one set of slabs and one free list per block size and alignment, and
+ * counters covering all of them.
+ */
+class NodePoolState {
+ public:
+  struct FreeNode {
+    FreeNode *next;
+  };
+
+  struct SizeClass {
+    size_t block_size;
+    size_t block_align;
+    size_t slab_nodes;
+    vector<void *> slabs;
+    FreeNode *free_list = nullptr;
+    char *bump = nullptr;
+    char *bump_end = nullptr;
+  };
+
+  // `unique_ptr` so that the `SizeClass` each pool caches stays put.
+  vector<unique_ptr<SizeClass>> classes;
+  NodePoolStats stats;
+
+  /**
+   * Returns the size class for the given block layout, creating it on first
+   * use.
+   */
+  SizeClass &size_class(size_t block_size, size_t block_align,
+                        size_t slab_nodes) {
+    for (const unique_ptr<SizeClass> &c : classes) {
+      if (c->block_size == block_size && c->block_align == block_align) {
+        return *c;
+      }
+    }
+    auto c = make_unique<SizeClass>();
+    c->block_size = block_size;
+    c->block_align = block_align;
+    c->slab_nodes = slab_nodes;
+    classes.push_back(std::move(c));
+    return *classes.back();
+  }
+
+  void release_slabs() {
+    for (const unique_ptr<SizeClass> &c : classes) {
+      for (void *slab : c->slabs) {
+        ::operator delete(slab, align_val_t(c->block_align));
+      }
+      c->slabs.clear();
+      c->free_list = nullptr;
+      c->bump = nullptr;
+      c->bump_end = nullptr;
+    }
+    stats.slabs = 0;
+  }
+
+  ~NodePoolState() {
+    release_slabs();
+  }
+};
+
+/**
+ * Slab allocator for fixed-size nodes. Objects are carved out of slabs of
+ * `SlabNodes` blocks, freed objects go onto an intrusive free list for reuse,
+ * and slabs are only returned to the heap by `release()` (once nothing is
+ * live) or when the last copy of the pool is destroyed.
+ *
+ * Meets the standard allocator requirements, so it can be passed as the
+ * `Alloc` parameter of `LinkedList`, which rebinds it to its node type.
+ * Copies share one pool, and so do rebound copies: a `NodePool<Node>` made
+ * from a `NodePool<T>` draws from the same state (with slabs of its own
+ * block size) and compares equal to it. Copying a container gives the copy
+ * a fresh pool. Requests for more than one object bypass the slabs and go
+ * straight to `operator new`.
+ */
+template <typename T, size_t SlabNodes = 512>
+class NodePool {
+ private:
+  using FreeNode = NodePoolState::FreeNode;
+
+  static constexpr size_t block_align = max(alignof(T), alignof(FreeNode));
+  static constexpr size_t block_size =
+      (max(sizeof(T), sizeof(FreeNode)) + block_align - 1) / block_align *
+      block_align;
+
+  shared_ptr<NodePoolState> state;
+  // This type's size class within `state`.
+  NodePoolState::SizeClass *blocks;
+
+  template <typename U, size_t N>
+  friend class NodePool;
+
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = false_type;
+  using propagate_on_container_move_assignment = true_type;
+  using propagate_on_container_swap = true_type;
+
+  template <typename U>
+  struct rebind {
+    using other = NodePool<U, SlabNodes>;
+  };
+
+  /**
+   * Creates an empty pool. No memory is reserved until the first allocation.
+   */
+  NodePool() {
+    state = make_shared<NodePoolState>();
+    blocks = &state->size_class(block_size, block_align, SlabNodes);
+  }
+
+  NodePool(const NodePool &other) = default;
+
+  /**
+   * Rebinding constructor. Shares `other`'s pool, using the slabs for this
+   * type's block size.
+   */
+  template <typename U>
+  NodePool(const NodePool<U, SlabNodes> &other) : state(other.state) {
+    blocks = &state->size_class(block_size, block_align, SlabNodes);
+  }
+
+  /**
+   * Copied containers get a pool of their own rather than sharing ours.
+   */
+  NodePool select_on_container_copy_construction() const {
+    return NodePool();
+  }
+
+  T *allocate(size_t n) {
+    NodePoolStats &stats = state->stats;
+    if (n != 1) {
+      stats.heap_allocations++;
+      return static_cast<T *>(
+          ::operator new(n * sizeof(T), align_val_t(alignof(T))));
+    }
+
+    NodePoolState::SizeClass &c = *blocks;
+    stats.allocations++;
+    stats.live++;
+    if (c.free_list != nullptr) {
+      FreeNode *block = c.free_list;
+      c.free_list = block->next;
+      stats.reuses++;
+      return reinterpret_cast<T *>(block);
+    }
+
+    if (c.bump == c.bump_end) {
+      size_t slab_bytes = block_size * c.slab_nodes;
+      char *slab = static_cast<char *>(
+          ::operator new(slab_bytes, align_val_t(block_align)));
+      c.slabs.push_back(slab);
+      c.bump = slab;
+      c.bump_end = slab + slab_bytes;
+      stats.heap_allocations++;
+      stats.slabs++;
+    }
+    T *block = reinterpret_cast<T *>(c.bump);
+    c.bump += block_size;
+    return block;
+  }
+
+  void deallocate(T *p, size_t n) {
+    if (n != 1) {
+      ::operator delete(p, align_val_t(alignof(T)));
+      return;
+    }
+
+    FreeNode *block = reinterpret_cast<FreeNode *>(p);
+    block->next = blocks->free_list;
+    blocks->free_list = block;
+    state->stats.live--;
+  }
+
+  /**
+   * Returns every slab to the heap, provided no objects are still live in
+   * any size class. Otherwise does nothing.
+   */
+  void release() {
+    if (state->stats.live == 0) {
+      state->release_slabs();
+    }
+  }
+
+  /**
+   * Returns a snapshot of the pool's allocation counters, summed over all
+   * the types the pool has been rebound to.
+   */
+  NodePoolStats stats() const {
+    return state->stats;
+  }
+
+  template <typename U>
+  bool operator==(const NodePool<U, SlabNodes> &other) const {
+    return state == other.state;
+  }
+};
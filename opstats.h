@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * Opt-in operation counters for `CircVector` and `LinkedList`. Build with
+ * `-DCONTAINER_STATS=1` (`make test_stats` does) and every container counts
+ * its own work; read it with `stats()` and zero it with `reset_stats()`.
+ * Without the flag the counters are an empty member, every hook compiles to
+ * nothing, and `stats()` returns all zeros.
+ *
+ * The flag changes the containers' layout, so it must be the same in every
+ * translation unit of a program.
+ */
+
+#ifndef CONTAINER_STATS
+#define CONTAINER_STATS 0
+#endif
+
+/**
+ * A snapshot of one container's counters. Fields that do not apply to a
+ * container stay 0.
+ */
+struct OpStats {
+  // Buffer reallocations (`CircVector`), and the bytes of live elements
+  // moved by them.
+  uint64_t resizes = 0;
+  uint64_t bytes_moved = 0;
+  // Elements moved one slot by `insert_after`/`remove_at` (`CircVector`).
+  uint64_t elements_shifted = 0;
+  // Nodes allocated and freed (`LinkedList`).
+  uint64_t nodes_allocated = 0;
+  uint64_t nodes_freed = 0;
+  // `next`/`prev` pointers followed by `at`, `find`, `pop_back` and the
+  // other indexed operations (`LinkedList`).
+  uint64_t pointer_hops = 0;
+  // High-water marks since construction or the last reset.
+  uint64_t peak_size = 0;
+  uint64_t peak_capacity = 0;
+};
+
+inline constexpr bool container_stats_enabled = CONTAINER_STATS != 0;
+
+/**
+ * The counters a container embeds (as a `[[no_unique_address]] mutable`
+ * member, so `const` lookups can count too). Empty unless `CONTAINER_STATS`
+ * is set.
+ */
+class OpCounters {
+#if CONTAINER_STATS
+ private:
+  OpStats counts;
+
+ public:
+  void add_resize(size_t bytes) {
+    counts.resizes++;
+    counts.bytes_moved += bytes;
+  }
+
+  void add_shifted(size_t n) {
+    counts.elements_shifted += n;
+  }
+
+  void add_node_allocated() {
+    counts.nodes_allocated++;
+  }
+
+  void add_node_freed() {
+    counts.nodes_freed++;
+  }
+
+  void add_hops(size_t n) {
+    counts.pointer_hops += n;
+  }
+
+  void note_size(size_t size) {
+    counts.peak_size = max<uint64_t>(counts.peak_size, size);
+  }
+
+  void note_capacity(size_t capacity) {
+    counts.peak_capacity = max<uint64_t>(counts.peak_capacity, capacity);
+  }
+
+  OpStats snapshot() const {
+    return counts;
+  }
+
+  void reset() {
+    counts = OpStats();
+  }
+#else
+ public:
+  void add_resize(size_t) {
+  }
+
+  void add_shifted(size_t) {
+  }
+
+  void add_node_allocated() {
+  }
+
+  void add_node_freed() {
+  }
+
+  void add_hops(size_t) {
+  }
+
+  void note_size(size_t) {
+  }
+
+  void note_capacity(size_t) {
+  }
+
+  OpStats snapshot() const {
+    return OpStats();
+  }
+
+  void reset() {
+  }
+#endif
+};
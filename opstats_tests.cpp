@@ -0,0 +1,67 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "circvector.h"
+#include "linkedlist.h"
+
+using namespace std;
+using namespace testing;
+
+// Built into its own binary with CONTAINER_STATS=1 (`make test_stats`); the
+// flag changes the containers' layout, so it cannot share list_tests.
+
+TEST(OpStats, circVector) {
+  ASSERT_THAT(container_stats_enabled, Eq(true));
+  CircVector<int> v(4);
+  for (int i = 0; i < 9; i++) {
+    v.push_back(i);
+  }
+  OpStats s = v.stats();
+  EXPECT_THAT(s.resizes, Eq(2));
+  EXPECT_THAT(s.bytes_moved, Eq((4 + 8) * sizeof(int)));
+  EXPECT_THAT(s.peak_size, Eq(9));
+  EXPECT_THAT(s.peak_capacity, Eq(16));
+
+  v.reset_stats();
+  v.insert_after(1, 100);
+  v.remove_at(0);
+  s = v.stats();
+  // Both edits move the shorter side: the two elements in front of the
+  // insertion point, and nothing for the front element.
+  EXPECT_THAT(s.elements_shifted, Eq(2 + 0));
+  EXPECT_THAT(s.resizes, Eq(0));
+  EXPECT_THAT(s.peak_size, Eq(10));
+  EXPECT_THAT(s.peak_capacity, Eq(16));
+  EXPECT_THAT(s.nodes_allocated, Eq(0));
+
+  CircVector<int> copy(v);
+  EXPECT_THAT(copy.stats().elements_shifted, Eq(0));
+  EXPECT_THAT(copy.stats().peak_size, Eq(9));
+}
+TEST(OpStats, linkedList) {
+  LinkedList<int> list;
+  for (int i = 0; i < 10; i++) {
+    list.push_back(i);
+  }
+  list.at(7);
+  list.find(4);
+  list.pop_back();
+  list.pop_front();
+  OpStats s = list.stats();
+  EXPECT_THAT(s.nodes_allocated, Eq(10));
+  EXPECT_THAT(s.nodes_freed, Eq(2));
+  EXPECT_THAT(s.pointer_hops, Eq(7 + 4 + 8));
+  EXPECT_THAT(s.peak_size, Eq(10));
+  EXPECT_THAT(s.resizes, Eq(0));
+
+  // Doubly-linked lists walk from the closer end.
+  DList<int> dlist;
+  for (int i = 0; i < 10; i++) {
+    dlist.push_back(i);
+  }
+  dlist.reset_stats();
+  dlist.at(7);
+  dlist.pop_back();
+  EXPECT_THAT(dlist.stats().pointer_hops, Eq(2));
+  EXPECT_THAT(dlist.stats().peak_size, Eq(10));
+}
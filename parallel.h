@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "circvector.h"
+#include "simdscan.h"
+
+using namespace std;
+
+/**
+ * A fixed set of worker threads for fork-join loops. `run(tasks, fn)` calls
+ * `fn(0)` through `fn(tasks - 1)`, spread over the workers and the calling
+ * thread, and returns once every call has finished. Tasks are handed out in
+ * increasing order, one at a time, so an early task never waits behind a
+ * later one.
+ *
+ * Concurrent `run` calls are serialized. `run` must not be called from inside
+ * a task of the same pool.
+ */
+class ThreadPool {
+ private:
+  vector<thread> workers;
+
+  // Serializes `run` calls.
+  mutex run_lock;
+
+  // Guards the job description below and the worker hand-shake.
+  mutex lock;
+  condition_variable wake;
+  condition_variable finished;
+  const function<void(size_t)> *job = nullptr;
+  size_t job_tasks = 0;
+  size_t generation = 0;
+  size_t busy = 0;
+  bool stopping = false;
+  exception_ptr error;
+
+  atomic<size_t> next_task{0};
+
+  /**
+   * Claims and runs tasks of the current job until none are left. The first
+   * exception is kept for `run` to rethrow, and the remaining tasks are
+   * skipped.
+   */
+  void drain(const function<void(size_t)> &fn, size_t tasks) {
+    for (size_t i = next_task.fetch_add(1); i < tasks;
+         i = next_task.fetch_add(1)) {
+      try {
+        fn(i);
+      }
+      catch (...) {
+        lock_guard<mutex> guard(lock);
+        if (!error) {
+          error = current_exception();
+        }
+        next_task.store(tasks);
+      }
+    }
+  }
+
+  void work() {
+    size_t seen = 0;
+    unique_lock<mutex> guard(lock);
+    while (true) {
+      wake.wait(guard, [&] { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+      const function<void(size_t)> *fn = job;
+      size_t tasks = job_tasks;
+      guard.unlock();
+      drain(*fn, tasks);
+      guard.lock();
+      if (--busy == 0) {
+        finished.notify_one();
+      }
+    }
+  }
+
+ public:
+  /**
+   * Creates a pool that runs tasks on `threads` threads in total: the caller
+   * of `run` plus `threads - 1` workers. Zero means one thread per hardware
+   * thread.
+   */
+  explicit ThreadPool(size_t threads = 0) {
+    if (threads == 0) {
+      threads = max(1u, thread::hardware_concurrency());
+    }
+    for (size_t i = 1; i < threads; i++) {
+      workers.emplace_back([this] { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Returns how many threads run tasks, counting the caller of `run`.
+   */
+  size_t get_thread_count() const {
+    return workers.size() + 1;
+  }
+
+  /**
+   * Runs `fn(i)` for every `i` in `[0, tasks)` and waits for all of them. If
+   * a task throws, the tasks not yet started are skipped and the first
+   * exception is rethrown here.
+   */
+  void run(size_t tasks, const function<void(size_t)> &fn) {
+    if (tasks == 0) {
+      return;
+    }
+    lock_guard<mutex> serial(run_lock);
+    {
+      lock_guard<mutex> guard(lock);
+      job = &fn;
+      job_tasks = tasks;
+      next_task.store(0);
+      busy = workers.size();
+      generation++;
+    }
+    wake.notify_all();
+    drain(fn, tasks);
+
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [&] { return busy == 0; });
+    job = nullptr;
+    if (error) {
+      rethrow_exception(exchange(error, nullptr));
+    }
+  }
+
+  /**
+   * Returns the process-wide pool used when no pool is passed, with one
+   * thread per hardware thread.
+   */
+  static ThreadPool &instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+};
+
+/**
+ * Chunks smaller than this are not worth handing to another thread.
+ */
+inline constexpr size_t parallel_min_chunk = 4096;
+
+/**
+ * A contiguous run of a `CircVector`'s buffer, and the logical index of its
+ * first element.
+ */
+template <typename T>
+struct ParallelChunk {
+  T *data;
+  size_t size;
+  size_t offset;
+};
+
+/**
+ * Splits the two ring segments of `c` into chunks of roughly equal size,
+ * about four per thread so uneven chunks even out, in logical order. A
+ * chunk never straddles the wrap point.
+ */
+template <typename V>
+auto parallel_chunks(V &c, const ThreadPool &pool) {
+  auto [first, second] = c.as_spans();
+  using T = typename decltype(first)::element_type;
+  size_t n = first.size() + second.size();
+  size_t pieces = pool.get_thread_count() * 4;
+  size_t chunk = max(parallel_min_chunk, (n + pieces - 1) / pieces);
+
+  vector<ParallelChunk<T>> chunks;
+  size_t offset = 0;
+  for (span<T> run : {first, second}) {
+    for (size_t i = 0; i < run.size(); i += chunk) {
+      size_t len = min(chunk, run.size() - i);
+      chunks.push_back({run.data() + i, len, offset + i});
+    }
+    offset += run.size();
+  }
+  return chunks;
+}
+
+/**
+ * Runs `scan(data, size)` over the chunks of `c` and returns the logical
+ * index of the earliest match, or "-1". `scan` returns the position of the
+ * first match in its run, or `size` if there is none. Chunks that start
+ * after a match already found are skipped.
+ */
+template <typename T, bool P, typename A, size_t N, typename Scan>
+size_t parallel_find_first(const CircVector<T, P, A, N> &c, Scan scan,
+                           ThreadPool &pool) {
+  auto chunks = parallel_chunks(c, pool);
+  atomic<size_t> best(-1);
+  pool.run(chunks.size(), [&](size_t i) {
+    const ParallelChunk<const T> &chunk = chunks[i];
+    if (chunk.offset >= best.load(memory_order_relaxed)) {
+      return;
+    }
+    size_t hit = scan(chunk.data, chunk.size);
+    if (hit == chunk.size) {
+      return;
+    }
+    size_t index = chunk.offset + hit;
+    size_t current = best.load(memory_order_relaxed);
+    while (index < current && !best.compare_exchange_weak(current, index)) {
+    }
+  });
+  return best.load();
+}
+
+/**
+ * Parallel `CircVector::find`: returns the index of the first element equal
+ * to `target`, or "-1". Each chunk is scanned with the vectorized kernels
+ * where `T` allows.
+ */
+template <typename T, bool P, typename A, size_t N>
+size_t par_find(const CircVector<T, P, A, N> &c, const T &target,
+                ThreadPool &pool = ThreadPool::instance()) {
+  return parallel_find_first(
+      c,
+      [&](const T *data, size_t size) -> size_t {
+        if constexpr (simd_scannable<T>) {
+          return simd_find(data, size, target);
+        }
+        else {
+          return std::find(data, data + size, target) - data;
+        }
+      },
+      pool);
+}
+
+/**
+ * Returns the index of the first element for which `pred` is true, or "-1".
+ * `pred` may be called concurrently, and on elements after the match.
+ */
+template <typename T, bool P, typename A, size_t N, typename Pred>
+size_t par_find_if(const CircVector<T, P, A, N> &c, Pred pred,
+                   ThreadPool &pool = ThreadPool::instance()) {
+  return parallel_find_first(
+      c,
+      [&](const T *data, size_t size) -> size_t {
+        return std::find_if(data, data + size, pred) - data;
+      },
+      pool);
+}
+
+/**
+ * Returns how many elements satisfy `pred`.
+ */
+template <typename T, bool P, typename A, size_t N, typename Pred>
+size_t par_count_if(const CircVector<T, P, A, N> &c, Pred pred,
+                    ThreadPool &pool = ThreadPool::instance()) {
+  auto chunks = parallel_chunks(c, pool);
+  vector<size_t> partial(chunks.size());
+  pool.run(chunks.size(), [&](size_t i) {
+    partial[i] = std::count_if(chunks[i].data,
+                               chunks[i].data + chunks[i].size, pred);
+  });
+  size_t total = 0;
+  for (size_t count : partial) {
+    total += count;
+  }
+  return total;
+}
+
+/**
+ * Calls `fn(elem)` on every element, in no particular order. `fn` may modify
+ * the element it is given but nothing shared with other calls.
+ */
+template <typename T, bool P, typename A, size_t N, typename Fn>
+void par_for_each(CircVector<T, P, A, N> &c, Fn fn,
+                  ThreadPool &pool = ThreadPool::instance()) {
+  auto chunks = parallel_chunks(c, pool);
+  pool.run(chunks.size(), [&](size_t i) {
+    std::for_each(chunks[i].data, chunks[i].data + chunks[i].size, fn);
+  });
+}
+
+/**
+ * Writes `op(c.at(i))` to `out[i]` for every index, and returns `out` moved
+ * past the last element written. `out` must have room for `c.size()`
+ * elements; passing `c.begin()` transforms in place.
+ */
+template <typename T, bool P, typename A, size_t N, random_access_iterator Out,
+          typename Op>
+Out par_transform(const CircVector<T, P, A, N> &c, Out out, Op op,
+                  ThreadPool &pool = ThreadPool::instance()) {
+  auto chunks = parallel_chunks(c, pool);
+  pool.run(chunks.size(), [&](size_t i) {
+    std::transform(chunks[i].data, chunks[i].data + chunks[i].size,
+                   out + chunks[i].offset, op);
+  });
+  return out + c.size();
+}
+
+/**
+ * Folds every element into `init` with `op`. Each chunk is folded on its
+ * own, starting from its first element, and the partial results are then
+ * folded into `init` in logical order; so `op` must be associative, but
+ * need not be commutative. `R` need not be default-constructible.
+ */
+template <typename T, bool P, typename A, size_t N, typename R, typename Op>
+R par_reduce(const CircVector<T, P, A, N> &c, R init, Op op,
+             ThreadPool &pool = ThreadPool::instance()) {
+  auto chunks = parallel_chunks(c, pool);
+  vector<optional<R>> partial(chunks.size());
+  pool.run(chunks.size(), [&](size_t i) {
+    const T *data = chunks[i].data;
+    R acc = data[0];
+    for (size_t j = 1; j < chunks[i].size; j++) {
+      acc = op(std::move(acc), data[j]);
+    }
+    partial[i].emplace(std::move(acc));
+  });
+  for (optional<R> &part : partial) {
+    init = op(std::move(init), std::move(*part));
+  }
+  return init;
+}
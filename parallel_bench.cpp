@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "parallel.h"
+
+using namespace std;
+
+// Scaling of the parallel CircVector algorithms with the pool size. Each case
+// runs over a wrapped ring of 2^24 `int32_t`s (64 MiB); range(0) is the
+// pool size, where 1 runs every chunk on the calling thread.
+//
+//   ./list_bench --benchmark_filter=Parallel
+
+namespace {
+
+const size_t ring_size = size_t(1) << 24;
+
+const CircVector<int32_t> &shared_ring() {
+  static CircVector<int32_t> ring = [] {
+    CircVector<int32_t> c(ring_size);
+    for (size_t i = 0; i < ring_size / 2; i++) {
+      c.push_back(static_cast<int32_t>(i % 1000));
+    }
+    for (size_t i = ring_size / 2; i < ring_size; i++) {
+      c.push_front(static_cast<int32_t>(i % 1000));
+    }
+    return c;
+  }();
+  return ring;
+}
+
+void BM_ParallelFind(benchmark::State &state) {
+  ThreadPool pool(state.range(0));
+  const CircVector<int32_t> &c = shared_ring();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(par_find(c, int32_t(5000), pool));
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+void BM_ParallelCountIf(benchmark::State &state) {
+  ThreadPool pool(state.range(0));
+  const CircVector<int32_t> &c = shared_ring();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        par_count_if(c, [](int32_t x) { return x % 7 == 0; }, pool));
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+void BM_ParallelReduce(benchmark::State &state) {
+  ThreadPool pool(state.range(0));
+  const CircVector<int32_t> &c = shared_ring();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(par_reduce(c, int64_t(0), plus<int64_t>(), pool));
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+void BM_ParallelTransform(benchmark::State &state) {
+  ThreadPool pool(state.range(0));
+  const CircVector<int32_t> &c = shared_ring();
+  vector<int64_t> out(c.size());
+  for (auto _ : state) {
+    par_transform(
+        c, out.begin(), [](int32_t x) { return int64_t(x) * x; }, pool);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+void PoolSizes(benchmark::internal::Benchmark *b) {
+  int max_threads = max(2u, thread::hardware_concurrency());
+  b->ArgName("threads");
+  for (int t = 1; t < max_threads; t *= 2) {
+    b->Arg(t);
+  }
+  b->Arg(max_threads);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ParallelFind)->Apply(PoolSizes)->UseRealTime();
+BENCHMARK(BM_ParallelCountIf)->Apply(PoolSizes)->UseRealTime();
+BENCHMARK(BM_ParallelReduce)->Apply(PoolSizes)->UseRealTime();
+BENCHMARK(BM_ParallelTransform)->Apply(PoolSizes)->UseRealTime();
@@ -0,0 +1,129 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "parallel.h"
+
+using namespace std;
+using namespace testing;
+
+namespace {
+
+// A ring of 0..n-1 in logical order, with the first half wrapped around the
+// end of the buffer so both segments get several chunks.
+CircVector<int> make_wrapped(int n) {
+  CircVector<int> c(n);
+  for (int i = n / 2; i < n; i++) {
+    c.push_back(i);
+  }
+  for (int i = n / 2 - 1; i >= 0; i--) {
+    c.push_front(i);
+  }
+  return c;
+}
+
+}  // namespace
+
+TEST(ParallelPool, runsEveryTaskOnce) {
+  ThreadPool pool(4);
+  EXPECT_THAT(pool.get_thread_count(), Eq(4));
+
+  vector<atomic<int>> hits(1000);
+  for (int round = 0; round < 3; round++) {
+    pool.run(hits.size(), [&](size_t i) { hits[i]++; });
+  }
+  bool all_three = true;
+  for (atomic<int> &h : hits) {
+    all_three = all_three && h == 3;
+  }
+  EXPECT_THAT(all_three, Eq(true));
+
+  EXPECT_THROW(pool.run(100,
+                        [](size_t i) {
+                          if (i == 10) {
+                            throw runtime_error("task failed");
+                          }
+                        }),
+               runtime_error);
+  atomic<int> after(0);
+  pool.run(5, [&](size_t) { after++; });
+  EXPECT_THAT(after.load(), Eq(5));
+}
+TEST(ParallelCircVector, findEarliestMatch) {
+  ThreadPool pool(4);
+  CircVector<int> c = make_wrapped(100000);
+  ASSERT_THAT(c.as_spans().second.empty(), Eq(false));
+
+  EXPECT_THAT(par_find(c, 0, pool), Eq(0));
+  EXPECT_THAT(par_find(c, 77777, pool), Eq(77777));
+  EXPECT_THAT(par_find(c, 99999, pool), Eq(99999));
+  EXPECT_THAT(par_find(c, -5, pool), Eq(size_t(-1)));
+  // Every element from 30000 on matches; the first must win.
+  EXPECT_THAT(par_find_if(c, [](int x) { return x >= 30000; }, pool),
+              Eq(30000));
+  EXPECT_THAT(par_find(CircVector<int>(), 1, pool), Eq(size_t(-1)));
+
+  CircVector<string> words;
+  for (int i = 0; i < 10000; i++) {
+    words.push_back(i % 2 ? "odd" : "even");
+  }
+  words.push_back("last");
+  EXPECT_THAT(par_find(words, string("last"), pool), Eq(10000));
+}
+TEST(ParallelCircVector, countForEachTransformReduce) {
+  ThreadPool pool(3);
+  CircVector<int> c = make_wrapped(50000);
+
+  EXPECT_THAT(par_count_if(c, [](int x) { return x % 3 == 0; }, pool),
+              Eq(16667));
+
+  par_for_each(c, [](int &x) { x *= 2; }, pool);
+  EXPECT_THAT(c.at(0), Eq(0));
+  EXPECT_THAT(c.at(49999), Eq(99998));
+
+  vector<long> out(c.size());
+  auto end = par_transform(
+      c, out.begin(), [](int x) { return long(x) + 1; }, pool);
+  EXPECT_THAT(end == out.end(), Eq(true));
+  EXPECT_THAT(out[0], Eq(1));
+  EXPECT_THAT(out[25000], Eq(50001));
+  par_transform(c, c.begin(), [](int x) { return x / 2; }, pool);
+  EXPECT_THAT(c.at(49999), Eq(49999));
+
+  long sum = par_reduce(c, 0L, plus<long>(), pool);
+  EXPECT_THAT(sum, Eq(50000L * 49999 / 2));
+  EXPECT_THAT(par_reduce(CircVector<int>(), 7L, plus<long>(), pool), Eq(7));
+
+  // Not commutative: partial results must be folded back in order.
+  CircVector<string> letters;
+  string expected = ">";
+  for (int i = 0; i < 20000; i++) {
+    letters.push_back(string(1, 'a' + i % 26));
+    expected += letters.at(i);
+  }
+  EXPECT_THAT(par_reduce(letters, string(">"), plus<string>(), pool),
+              Eq(expected));
+
+  // No default constructor: partial results are built only as they exist.
+  struct Total {
+    long value;
+    Total(long value) : value(value) {
+    }
+  };
+  auto add = [](Total acc, const auto &x) {
+    if constexpr (is_same_v<decay_t<decltype(x)>, Total>) {
+      return Total(acc.value + x.value);
+    }
+    else {
+      return Total(acc.value + x);
+    }
+  };
+  EXPECT_THAT(par_reduce(c, Total(0), add, pool).value,
+              Eq(50000L * 49999 / 2));
+}
@@ -0,0 +1,248 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "circvector.h"
+#include "mpmcring.h"
+#include "spscring.h"
+
+using namespace std;
+
+// Producer/consumer hand-off benchmarks. Each iteration streams a fixed
+// number of items from producer threads to consumer threads, and reports
+// items per second of wall time.
+
+namespace {
+
+const size_t items_per_iteration = 1 << 20;
+const size_t queue_capacity = 1 << 12;
+
+// Baseline: the mutex-wrapped CircVector hand-off the ring replaces.
+class MutexQueue {
+ private:
+  mutex lock;
+  CircVector<uint64_t> queue;
+  size_t capacity;
+
+ public:
+  explicit MutexQueue(size_t capacity = queue_capacity) : capacity(capacity) {
+  }
+
+  bool try_push(uint64_t value) {
+    lock_guard<mutex> guard(lock);
+    if (queue.size() == capacity) {
+      return false;
+    }
+    queue.push_back(value);
+    return true;
+  }
+
+  bool try_pop(uint64_t &out) {
+    lock_guard<mutex> guard(lock);
+    if (queue.empty()) {
+      return false;
+    }
+    out = queue.pop_front();
+    return true;
+  }
+};
+
+void BM_MutexCircVector(benchmark::State &state) {
+  for (auto _ : state) {
+    MutexQueue queue;
+    thread producer([&] {
+      for (uint64_t i = 0; i < items_per_iteration;) {
+        if (queue.try_push(i)) {
+          i++;
+        }
+        else {
+          this_thread::yield();
+        }
+      }
+    });
+    uint64_t sum = 0;
+    uint64_t out = 0;
+    for (size_t received = 0; received < items_per_iteration;) {
+      if (queue.try_pop(out)) {
+        sum += out;
+        received++;
+      }
+      else {
+        this_thread::yield();
+      }
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * items_per_iteration);
+}
+
+// Single-item try_push/try_pop.
+void BM_SpscRing(benchmark::State &state) {
+  for (auto _ : state) {
+    SpscRing<uint64_t> ring(queue_capacity);
+    thread producer([&] {
+      for (uint64_t i = 0; i < items_per_iteration;) {
+        if (ring.try_push(i)) {
+          i++;
+        }
+        else {
+          this_thread::yield();
+        }
+      }
+    });
+    uint64_t sum = 0;
+    uint64_t out = 0;
+    for (size_t received = 0; received < items_per_iteration;) {
+      if (ring.try_pop(out)) {
+        sum += out;
+        received++;
+      }
+      else {
+        this_thread::yield();
+      }
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * items_per_iteration);
+}
+
+// Batched transfers; the batch size is the benchmark argument.
+void BM_SpscRingBatch(benchmark::State &state) {
+  size_t batch = state.range(0);
+  for (auto _ : state) {
+    SpscRing<uint64_t> ring(queue_capacity);
+    thread producer([&] {
+      vector<uint64_t> items(batch);
+      for (uint64_t i = 0; i < items_per_iteration;) {
+        size_t n = min<size_t>(batch, items_per_iteration - i);
+        for (size_t j = 0; j < n; j++) {
+          items[j] = i + j;
+        }
+        size_t pushed = ring.try_push_batch(items.data(), n);
+        if (pushed == 0) {
+          this_thread::yield();
+        }
+        i += pushed;
+      }
+    });
+    vector<uint64_t> out(batch);
+    uint64_t sum = 0;
+    for (size_t received = 0; received < items_per_iteration;) {
+      size_t n = ring.try_pop_batch(out.data(), batch);
+      if (n == 0) {
+        this_thread::yield();
+      }
+      for (size_t j = 0; j < n; j++) {
+        sum += out[j];
+      }
+      received += n;
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * items_per_iteration);
+}
+
+template <typename Wait>
+using Mpmc = MpmcRing<uint64_t, Wait>;
+
+// Splits `total` items as evenly as possible into `parts` shares.
+size_t share(size_t total, size_t parts, size_t index) {
+  return total / parts + (index < total % parts ? 1 : 0);
+}
+
+// Fan-in/fan-out: range(0) producers and range(1) consumers share one queue.
+// `Q` is either `MutexQueue` (retrying with a yield) or an `MpmcRing` (using
+// its blocking push/pop, so the wait strategy is what is measured).
+template <typename Q>
+void BM_ManyToMany(benchmark::State &state) {
+  size_t producers = state.range(0);
+  size_t consumers = state.range(1);
+  for (auto _ : state) {
+    Q queue(queue_capacity);
+    vector<thread> threads;
+    vector<uint64_t> sums(consumers);
+    for (size_t p = 0; p < producers; p++) {
+      threads.emplace_back([&, p] {
+        size_t n = share(items_per_iteration, producers, p);
+        for (uint64_t i = 0; i < n;) {
+          if constexpr (requires { queue.push(i); }) {
+            queue.push(i++);
+          }
+          else if (queue.try_push(i)) {
+            i++;
+          }
+          else {
+            this_thread::yield();
+          }
+        }
+      });
+    }
+    for (size_t c = 0; c < consumers; c++) {
+      threads.emplace_back([&, c] {
+        size_t n = share(items_per_iteration, consumers, c);
+        uint64_t sum = 0;
+        uint64_t out = 0;
+        for (size_t received = 0; received < n;) {
+          if constexpr (requires { queue.pop(out); }) {
+            queue.pop(out);
+            sum += out;
+            received++;
+          }
+          else if (queue.try_pop(out)) {
+            sum += out;
+            received++;
+          }
+          else {
+            this_thread::yield();
+          }
+        }
+        sums[c] = sum;
+      });
+    }
+    for (thread &t : threads) {
+      t.join();
+    }
+    benchmark::DoNotOptimize(sums);
+  }
+  state.SetItemsProcessed(state.iterations() * items_per_iteration);
+}
+
+// Producer and consumer counts 1, 2, 4, ... up to the number of hardware
+// threads (at least 2).
+void ThreadCounts(benchmark::internal::Benchmark *b) {
+  int max_threads = max(2u, thread::hardware_concurrency());
+  for (int p = 1; p <= max_threads; p *= 2) {
+    for (int c = 1; c <= max_threads; c *= 2) {
+      b->Args({p, c});
+    }
+  }
+  b->ArgNames({"producers", "consumers"});
+}
+
+}  // namespace
+
+BENCHMARK(BM_MutexCircVector)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SpscRing)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SpscRingBatch)
+    ->RangeMultiplier(4)
+    ->Range(4, 256)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+#define MANY_TO_MANY_BENCHMARK(Q)      \
+  BENCHMARK_TEMPLATE(BM_ManyToMany, Q) \
+      ->Apply(ThreadCounts)            \
+      ->UseRealTime()                  \
+      ->Unit(benchmark::kMillisecond)
+
+MANY_TO_MANY_BENCHMARK(MutexQueue);
+MANY_TO_MANY_BENCHMARK(Mpmc<SpinWait>);
+MANY_TO_MANY_BENCHMARK(Mpmc<YieldWait>);
+MANY_TO_MANY_BENCHMARK(Mpmc<BlockingWait>);
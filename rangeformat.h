@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+using namespace std;
+
+/**
+ * Fast `[0, 1, 2]` formatting shared by the containers' `to_string` and
+ * `write_to`. The output is byte-identical to streaming each element into a
+ * default-constructed `stringstream`, but integers and floating-point values
+ * are converted with `to_chars` (locale-independent, as the classic locale
+ * streams them) into a fixed stack buffer, and strings are copied as they
+ * are, so no stream is built and nothing is allocated. Other types still go
+ * through their `operator<<`, using one `ostringstream` per call.
+ */
+
+/**
+ * Types printed with `to_chars`. Character types and `bool` are left to
+ * `operator<<`, which prints them differently.
+ */
+template <typename T>
+constexpr bool to_chars_formattable =
+    (is_integral_v<T> && !is_same_v<T, bool> && !is_same_v<T, char> &&
+     !is_same_v<T, signed char> && !is_same_v<T, unsigned char> &&
+     !is_same_v<T, wchar_t> && !is_same_v<T, char8_t> &&
+     !is_same_v<T, char16_t> && !is_same_v<T, char32_t>) ||
+    is_floating_point_v<T>;
+
+// Stack buffer per call, and the room reserved for one converted number,
+// which is more than the longest 128-bit integer or `%g` float needs.
+inline constexpr size_t format_buffer_size = 4096;
+inline constexpr size_t format_number_chars = 64;
+
+/**
+ * Writes `range` as `[a, b, c]` by calling `put(const char *, size_t)` with
+ * successive pieces of the output, at most `format_buffer_size` bytes at a
+ * time (or one whole element, if that is longer).
+ */
+template <ranges::input_range R, typename Put>
+void format_range(const R &range, Put &&put) {
+  char buf[format_buffer_size];
+  size_t len = 0;
+  optional<ostringstream> fallback;
+
+  auto flush = [&] {
+    if (len > 0) {
+      put(buf, len);
+      len = 0;
+    }
+  };
+  auto append = [&](const char *p, size_t n) {
+    if (len + n > format_buffer_size) {
+      flush();
+      if (n > format_buffer_size) {
+        put(p, n);
+        return;
+      }
+    }
+    memcpy(buf + len, p, n);
+    len += n;
+  };
+
+  append("[", 1);
+  bool first = true;
+  for (const auto &elem : range) {
+    using E = remove_cvref_t<decltype(elem)>;
+    if (!first) {
+      append(", ", 2);
+    }
+    first = false;
+
+    if constexpr (to_chars_formattable<E>) {
+      if (format_buffer_size - len < format_number_chars) {
+        flush();
+      }
+      char *end;
+      if constexpr (is_floating_point_v<E>) {
+        // Streams default to `%g` with precision 6.
+        end = to_chars(buf + len, buf + format_buffer_size, elem,
+                       chars_format::general, 6)
+                  .ptr;
+      }
+      else {
+        end = to_chars(buf + len, buf + format_buffer_size, elem).ptr;
+      }
+      len = end - buf;
+    }
+    else if constexpr (is_convertible_v<const E &, string_view>) {
+      string_view text = elem;
+      append(text.data(), text.size());
+    }
+    else {
+      if (!fallback) {
+        fallback.emplace();
+      }
+      else {
+        fallback->str("");
+      }
+      *fallback << elem;
+      string_view text = fallback->view();
+      append(text.data(), text.size());
+    }
+  }
+  append("]", 1);
+  flush();
+}
+
+#ifdef __cpp_lib_format
+/**
+ * Base for the containers' `std::formatter` specializations: `{}` prints the
+ * `to_string` form, written straight to the output. No format spec is
+ * accepted.
+ */
+struct RangeFormatter {
+  constexpr auto parse(format_parse_context &ctx) {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it != '}') {
+      throw format_error("containers take no format spec");
+    }
+    return it;
+  }
+
+  template <typename R>
+  auto format(const R &range, format_context &ctx) const {
+    auto out = ctx.out();
+    format_range(range, [&](const char *p, size_t n) {
+      out = copy_n(p, n, out);
+    });
+    return out;
+  }
+};
+#endif
@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "circvector.h"
+#include "simdscan.h"
+
+using namespace std;
+
+// Equality scans over a wrapped CircVector, per instruction set. Each case
+// scans the whole ring for a value that is not there, so the reported rate
+// is elements compared per second.
+//
+//   ./list_bench --benchmark_filter=Scan
+
+namespace {
+
+// A ring of `n` elements, half of them wrapped around the end of the buffer.
+template <typename T>
+CircVector<T> make_ring(size_t n) {
+  CircVector<T> c(n);
+  for (size_t i = 0; i < n / 2; i++) {
+    c.push_back(static_cast<T>(i % 1000));
+  }
+  for (size_t i = n / 2; i < n; i++) {
+    c.push_front(static_cast<T>(i % 1000));
+  }
+  return c;
+}
+
+// Baseline: the original find loop, with a modulo on every element.
+template <typename T>
+void BM_ScanModulo(benchmark::State &state) {
+  size_t n = state.range(0);
+  CircVector<T> c = make_ring<T>(n);
+  const T *data = c.get_data();
+  size_t capacity = c.get_capacity();
+  size_t front = c.as_spans().first.data() - data;
+  T missing = static_cast<T>(5000);
+  for (auto _ : state) {
+    size_t found = -1;
+    for (size_t i = 0; i < n; i++) {
+      if (data[(front + i) % capacity] == missing) {
+        found = i;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// range(0) is the instruction set (a `SimdIsa`), range(1) the ring size.
+template <typename T>
+void BM_ScanFind(benchmark::State &state) {
+  SimdIsa isa = static_cast<SimdIsa>(state.range(0));
+  if (!simd_supported(isa)) {
+    state.SkipWithError("instruction set not supported on this CPU");
+    return;
+  }
+  state.SetLabel(simd_isa_name(isa));
+  size_t n = state.range(1);
+  CircVector<T> c = make_ring<T>(n);
+  auto [first, second] = c.as_spans();
+  T missing = static_cast<T>(5000);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        simd_find(first.data(), first.size(), missing, isa));
+    benchmark::DoNotOptimize(
+        simd_find(second.data(), second.size(), missing, isa));
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+void BM_ScanCount(benchmark::State &state) {
+  SimdIsa isa = static_cast<SimdIsa>(state.range(0));
+  if (!simd_supported(isa)) {
+    state.SkipWithError("instruction set not supported on this CPU");
+    return;
+  }
+  state.SetLabel(simd_isa_name(isa));
+  size_t n = state.range(1);
+  CircVector<T> c = make_ring<T>(n);
+  auto [first, second] = c.as_spans();
+  T value = static_cast<T>(7);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        simd_count(first.data(), first.size(), value, isa) +
+        simd_count(second.data(), second.size(), value, isa));
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+void ScanSizes(benchmark::internal::Benchmark *b) {
+  b->RangeMultiplier(10)->Range(1000, 10'000'000);
+}
+
+void IsaAndScanSizes(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"isa", "n"});
+  for (SimdIsa isa : {SimdIsa::Scalar, SimdIsa::Sse2, SimdIsa::Avx2}) {
+    for (int64_t n = 1000; n <= 10'000'000; n *= 10) {
+      b->Args({static_cast<int64_t>(isa), n});
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_ScanModulo, int32_t)->Apply(ScanSizes);
+BENCHMARK_TEMPLATE(BM_ScanModulo, uint64_t)->Apply(ScanSizes);
+BENCHMARK_TEMPLATE(BM_ScanFind, int32_t)->Apply(IsaAndScanSizes);
+BENCHMARK_TEMPLATE(BM_ScanFind, uint64_t)->Apply(IsaAndScanSizes);
+BENCHMARK_TEMPLATE(BM_ScanCount, int32_t)->Apply(IsaAndScanSizes);
+BENCHMARK_TEMPLATE(BM_ScanCount, uint64_t)->Apply(IsaAndScanSizes);
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMDSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+ * Vectorized equality scans over a contiguous array: `simd_find`,
+ * `simd_find_last` and `simd_count`. `CircVector` runs them over its two
+ * ring segments.
+ *
+ * On x86 there are SSE2 and AVX2 kernels, compiled with per-function target
+ * attributes so no extra build flags are needed; the best one the CPU
+ * supports is picked at run time. Everything else uses the scalar loop.
+ * Only 1-, 2-, 4- and 8-byte integral types, `float` and `double` are
+ * vectorized (`simd_scannable`). Floating-point lanes are compared with
+ * floating-point equality, so the results always match `==`.
+ */
+
+enum class SimdIsa { Scalar, Sse2, Avx2 };
+
+template <typename T>
+constexpr bool simd_scannable =
+    (is_integral_v<T> && (sizeof(T) == 1 || sizeof(T) == 2 ||
+                          sizeof(T) == 4 || sizeof(T) == 8)) ||
+    is_same_v<T, float> || is_same_v<T, double>;
+
+/**
+ * Returns whether this CPU can run kernels for `isa`.
+ */
+inline bool simd_supported(SimdIsa isa) {
+#ifdef SIMDSCAN_X86
+  switch (isa) {
+    case SimdIsa::Scalar:
+      return true;
+    case SimdIsa::Sse2:
+      return __builtin_cpu_supports("sse2");
+    case SimdIsa::Avx2:
+      return __builtin_cpu_supports("avx2");
+  }
+  return false;
+#else
+  return isa == SimdIsa::Scalar;
+#endif
+}
+
+/**
+ * Returns the widest instruction set this CPU supports, detected once.
+ */
+inline SimdIsa simd_best_isa() {
+  static const SimdIsa best = simd_supported(SimdIsa::Avx2)   ? SimdIsa::Avx2
+                              : simd_supported(SimdIsa::Sse2) ? SimdIsa::Sse2
+                                                              : SimdIsa::Scalar;
+  return best;
+}
+
+inline const char *simd_isa_name(SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::Sse2:
+      return "sse2";
+    case SimdIsa::Avx2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+// Scalar kernels. These also finish the tail that does not fill a vector.
+
+template <typename T>
+size_t scalar_find(const T *p, size_t n, T value) {
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] == value) {
+      return i;
+    }
+  }
+  return n;
+}
+
+template <typename T>
+size_t scalar_find_last(const T *p, size_t n, T value) {
+  for (size_t i = n; i > 0; i--) {
+    if (p[i - 1] == value) {
+      return i - 1;
+    }
+  }
+  return n;
+}
+
+template <typename T>
+size_t scalar_count(const T *p, size_t n, T value) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += (p[i] == value) ? 1 : 0;
+  }
+  return count;
+}
+
+#ifdef SIMDSCAN_X86
+
+// Each `*_eq` compares one vector at `p` with a broadcast `needle`, setting
+// matching lanes to all ones. `*_eq_mask` turns that into a byte mask: every
+// matching lane sets `sizeof(T)` consecutive bits, so dividing a bit position
+// by `sizeof(T)` gives the lane.
+
+template <typename T>
+__attribute__((target("sse2"), always_inline)) inline __m128i sse2_broadcast(
+    T value) {
+  if constexpr (is_same_v<T, float>) {
+    return _mm_castps_si128(_mm_set1_ps(value));
+  }
+  else if constexpr (is_same_v<T, double>) {
+    return _mm_castpd_si128(_mm_set1_pd(value));
+  }
+  else if constexpr (sizeof(T) == 1) {
+    return _mm_set1_epi8(static_cast<char>(value));
+  }
+  else if constexpr (sizeof(T) == 2) {
+    return _mm_set1_epi16(static_cast<short>(value));
+  }
+  else if constexpr (sizeof(T) == 4) {
+    return _mm_set1_epi32(static_cast<int>(value));
+  }
+  else {
+    return _mm_set1_epi64x(static_cast<long long>(value));
+  }
+}
+
+template <typename T>
+__attribute__((target("sse2"), always_inline)) inline __m128i sse2_eq(
+    const T *p, __m128i needle) {
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  __m128i eq;
+  if constexpr (is_same_v<T, float>) {
+    eq = _mm_castps_si128(
+        _mm_cmpeq_ps(_mm_castsi128_ps(v), _mm_castsi128_ps(needle)));
+  }
+  else if constexpr (is_same_v<T, double>) {
+    eq = _mm_castpd_si128(
+        _mm_cmpeq_pd(_mm_castsi128_pd(v), _mm_castsi128_pd(needle)));
+  }
+  else if constexpr (sizeof(T) == 1) {
+    eq = _mm_cmpeq_epi8(v, needle);
+  }
+  else if constexpr (sizeof(T) == 2) {
+    eq = _mm_cmpeq_epi16(v, needle);
+  }
+  else if constexpr (sizeof(T) == 4) {
+    eq = _mm_cmpeq_epi32(v, needle);
+  }
+  else {
+    // No 64-bit compare before SSE4.1: both 32-bit halves must match.
+    __m128i halves = _mm_cmpeq_epi32(v, needle);
+    eq = _mm_and_si128(halves,
+                       _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+  }
+  return eq;
+}
+
+template <typename T>
+__attribute__((target("sse2"), always_inline)) inline uint32_t sse2_eq_mask(
+    const T *p, __m128i needle) {
+  return static_cast<uint32_t>(_mm_movemask_epi8(sse2_eq(p, needle)));
+}
+
+template <typename T>
+__attribute__((target("avx2"), always_inline)) inline __m256i avx2_broadcast(
+    T value) {
+  if constexpr (is_same_v<T, float>) {
+    return _mm256_castps_si256(_mm256_set1_ps(value));
+  }
+  else if constexpr (is_same_v<T, double>) {
+    return _mm256_castpd_si256(_mm256_set1_pd(value));
+  }
+  else if constexpr (sizeof(T) == 1) {
+    return _mm256_set1_epi8(static_cast<char>(value));
+  }
+  else if constexpr (sizeof(T) == 2) {
+    return _mm256_set1_epi16(static_cast<short>(value));
+  }
+  else if constexpr (sizeof(T) == 4) {
+    return _mm256_set1_epi32(static_cast<int>(value));
+  }
+  else {
+    return _mm256_set1_epi64x(static_cast<long long>(value));
+  }
+}
+
+template <typename T>
+__attribute__((target("avx2"), always_inline)) inline __m256i avx2_eq(
+    const T *p, __m256i needle) {
+  __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  __m256i eq;
+  if constexpr (is_same_v<T, float>) {
+    eq = _mm256_castps_si256(_mm256_cmp_ps(
+        _mm256_castsi256_ps(v), _mm256_castsi256_ps(needle), _CMP_EQ_OQ));
+  }
+  else if constexpr (is_same_v<T, double>) {
+    eq = _mm256_castpd_si256(_mm256_cmp_pd(
+        _mm256_castsi256_pd(v), _mm256_castsi256_pd(needle), _CMP_EQ_OQ));
+  }
+  else if constexpr (sizeof(T) == 1) {
+    eq = _mm256_cmpeq_epi8(v, needle);
+  }
+  else if constexpr (sizeof(T) == 2) {
+    eq = _mm256_cmpeq_epi16(v, needle);
+  }
+  else if constexpr (sizeof(T) == 4) {
+    eq = _mm256_cmpeq_epi32(v, needle);
+  }
+  else {
+    eq = _mm256_cmpeq_epi64(v, needle);
+  }
+  return eq;
+}
+
+template <typename T>
+__attribute__((target("avx2"), always_inline)) inline uint32_t avx2_eq_mask(
+    const T *p, __m256i needle) {
+  return static_cast<uint32_t>(_mm256_movemask_epi8(avx2_eq(p, needle)));
+}
+
+// The loops are written out per instruction set, because the target
+// attribute has to be on the function that the intrinsics inline into.
+// `find` and `find_last` test two vectors per step before locating the hit.
+// `count` subtracts each all-ones compare result from per-byte counters, so
+// a matching lane adds one to each of its `sizeof(T)` bytes, and folds the
+// counters into a total with `sad_epu8` before any of them can overflow.
+
+// Vector steps between folds of the per-byte counters.
+constexpr size_t simd_count_fold = 255;
+
+template <typename T>
+__attribute__((target("sse2"))) size_t sse2_find(const T *p, size_t n,
+                                                 T value) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  __m128i needle = sse2_broadcast(value);
+  size_t i = 0;
+  for (; i + 2 * lanes <= n; i += 2 * lanes) {
+    uint32_t lo = sse2_eq_mask(p + i, needle);
+    uint32_t hi = sse2_eq_mask(p + i + lanes, needle);
+    if ((lo | hi) != 0) {
+      return (lo != 0) ? i + countr_zero(lo) / sizeof(T)
+                       : i + lanes + countr_zero(hi) / sizeof(T);
+    }
+  }
+  size_t rest = scalar_find(p + i, n - i, value);
+  return (rest == n - i) ? n : i + rest;
+}
+
+template <typename T>
+__attribute__((target("sse2"))) size_t sse2_find_last(const T *p, size_t n,
+                                                      T value) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  __m128i needle = sse2_broadcast(value);
+  size_t i = n;
+  for (; i >= 2 * lanes; i -= 2 * lanes) {
+    uint32_t lo = sse2_eq_mask(p + i - 2 * lanes, needle);
+    uint32_t hi = sse2_eq_mask(p + i - lanes, needle);
+    if ((lo | hi) != 0) {
+      return (hi != 0) ? i - lanes + (31 - countl_zero(hi)) / sizeof(T)
+                       : i - 2 * lanes + (31 - countl_zero(lo)) / sizeof(T);
+    }
+  }
+  size_t rest = scalar_find_last(p, i, value);
+  return (rest == i) ? n : rest;
+}
+
+template <typename T>
+__attribute__((target("sse2"))) size_t sse2_count(const T *p, size_t n,
+                                                  T value) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  __m128i needle = sse2_broadcast(value);
+  __m128i total = _mm_setzero_si128();
+  size_t i = 0;
+  while (i + lanes <= n) {
+    __m128i bytes = _mm_setzero_si128();
+    for (size_t step = 0; step < simd_count_fold && i + lanes <= n;
+         step++, i += lanes) {
+      bytes = _mm_sub_epi8(bytes, sse2_eq(p + i, needle));
+    }
+    total = _mm_add_epi64(total, _mm_sad_epu8(bytes, _mm_setzero_si128()));
+  }
+  alignas(16) uint64_t parts[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(parts), total);
+  size_t matched = parts[0] + parts[1];
+  return matched / sizeof(T) + scalar_count(p + i, n - i, value);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t avx2_find(const T *p, size_t n,
+                                                 T value) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  __m256i needle = avx2_broadcast(value);
+  size_t i = 0;
+  for (; i + 2 * lanes <= n; i += 2 * lanes) {
+    uint32_t lo = avx2_eq_mask(p + i, needle);
+    uint32_t hi = avx2_eq_mask(p + i + lanes, needle);
+    if ((lo | hi) != 0) {
+      return (lo != 0) ? i + countr_zero(lo) / sizeof(T)
+                       : i + lanes + countr_zero(hi) / sizeof(T);
+    }
+  }
+  size_t rest = scalar_find(p + i, n - i, value);
+  return (rest == n - i) ? n : i + rest;
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t avx2_find_last(const T *p, size_t n,
+                                                      T value) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  __m256i needle = avx2_broadcast(value);
+  size_t i = n;
+  for (; i >= 2 * lanes; i -= 2 * lanes) {
+    uint32_t lo = avx2_eq_mask(p + i - 2 * lanes, needle);
+    uint32_t hi = avx2_eq_mask(p + i - lanes, needle);
+    if ((lo | hi) != 0) {
+      return (hi != 0) ? i - lanes + (31 - countl_zero(hi)) / sizeof(T)
+                       : i - 2 * lanes + (31 - countl_zero(lo)) / sizeof(T);
+    }
+  }
+  size_t rest = scalar_find_last(p, i, value);
+  return (rest == i) ? n : rest;
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t avx2_count(const T *p, size_t n,
+                                                  T value) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  __m256i needle = avx2_broadcast(value);
+  __m256i total = _mm256_setzero_si256();
+  size_t i = 0;
+  while (i + lanes <= n) {
+    __m256i bytes = _mm256_setzero_si256();
+    for (size_t step = 0; step < simd_count_fold && i + lanes <= n;
+         step++, i += lanes) {
+      bytes = _mm256_sub_epi8(bytes, avx2_eq(p + i, needle));
+    }
+    total =
+        _mm256_add_epi64(total, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  alignas(32) uint64_t parts[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(parts), total);
+  size_t matched = parts[0] + parts[1] + parts[2] + parts[3];
+  return matched / sizeof(T) + scalar_count(p + i, n - i, value);
+}
+
+#endif
+
+/**
+ * Returns the index of the first element of `p[0, n)` equal to `value`, or
+ * `n` if there is none, using `isa` (which must be supported).
+ */
+template <typename T>
+size_t simd_find(const T *p, size_t n, T value,
+                 SimdIsa isa = simd_best_isa()) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    if (isa == SimdIsa::Avx2) {
+      return avx2_find(p, n, value);
+    }
+    if (isa == SimdIsa::Sse2) {
+      return sse2_find(p, n, value);
+    }
+  }
+#endif
+  return scalar_find(p, n, value);
+}
+
+/**
+ * Returns the index of the last element of `p[0, n)` equal to `value`, or
+ * `n` if there is none.
+ */
+template <typename T>
+size_t simd_find_last(const T *p, size_t n, T value,
+                      SimdIsa isa = simd_best_isa()) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    if (isa == SimdIsa::Avx2) {
+      return avx2_find_last(p, n, value);
+    }
+    if (isa == SimdIsa::Sse2) {
+      return sse2_find_last(p, n, value);
+    }
+  }
+#endif
+  return scalar_find_last(p, n, value);
+}
+
+/**
+ * Returns how many elements of `p[0, n)` equal `value`.
+ */
+template <typename T>
+size_t simd_count(const T *p, size_t n, T value,
+                  SimdIsa isa = simd_best_isa()) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    if (isa == SimdIsa::Avx2) {
+      return avx2_count(p, n, value);
+    }
+    if (isa == SimdIsa::Sse2) {
+      return sse2_count(p, n, value);
+    }
+  }
+#endif
+  return scalar_count(p, n, value);
+}
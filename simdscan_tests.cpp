@@ -0,0 +1,86 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "simdscan.h"
+
+using namespace std;
+using namespace testing;
+
+namespace {
+
+// Runs every kernel this CPU supports over arrays of every length up to 100
+// with matches planted at the edges and in the middle, and checks each
+// result against the scalar kernel.
+template <typename T>
+void check_kernels() {
+  for (SimdIsa isa : {SimdIsa::Scalar, SimdIsa::Sse2, SimdIsa::Avx2}) {
+    if (!simd_supported(isa)) {
+      continue;
+    }
+    SCOPED_TRACE(simd_isa_name(isa));
+    for (size_t n = 0; n <= 100; n++) {
+      vector<T> values(n);
+      for (size_t i = 0; i < n; i++) {
+        values[i] = static_cast<T>(i % 7 + 1);
+      }
+      const T needle = static_cast<T>(42);
+      for (size_t hit : {size_t(0), n / 3, n / 2, n - 1}) {
+        if (hit < n && n % 3 != 0) {
+          values[hit] = needle;
+        }
+      }
+      const T *p = values.data();
+      ASSERT_THAT(simd_find(p, n, needle, isa), Eq(scalar_find(p, n, needle)));
+      ASSERT_THAT(simd_find_last(p, n, needle, isa),
+                  Eq(scalar_find_last(p, n, needle)));
+      ASSERT_THAT(simd_count(p, n, needle, isa),
+                  Eq(scalar_count(p, n, needle)));
+      ASSERT_THAT(simd_count(p, n, static_cast<T>(3), isa),
+                  Eq(scalar_count(p, n, static_cast<T>(3))));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(SimdScan, integralKernelsMatchScalar) {
+  check_kernels<int8_t>();
+  check_kernels<uint16_t>();
+  check_kernels<int32_t>();
+  check_kernels<uint64_t>();
+}
+TEST(SimdScan, floatingKernelsMatchScalar) {
+  check_kernels<float>();
+  check_kernels<double>();
+}
+TEST(SimdScan, floatingEquality) {
+  // Lanes compare as floating point, not as bit patterns.
+  vector<double> values(20, 1.0);
+  values[5] = -0.0;
+  values[9] = NAN;
+  for (SimdIsa isa : {SimdIsa::Sse2, SimdIsa::Avx2}) {
+    if (!simd_supported(isa)) {
+      continue;
+    }
+    EXPECT_THAT(simd_find(values.data(), values.size(), 0.0, isa), Eq(5));
+    EXPECT_THAT(simd_count(values.data(), values.size(), double(NAN), isa),
+                Eq(0));
+  }
+}
+TEST(SimdScan, wideKeysNeedBothHalves) {
+  // Only the low or only the high 32 bits match: not a hit.
+  vector<uint64_t> values = {0x00000001'00000005, 0x00000005'00000001,
+                             0x00000001'00000001, 0, 0, 0, 0, 0};
+  for (SimdIsa isa : {SimdIsa::Sse2, SimdIsa::Avx2}) {
+    if (!simd_supported(isa)) {
+      continue;
+    }
+    EXPECT_THAT(simd_find(values.data(), values.size(),
+                          uint64_t(0x00000001'00000001), isa),
+                Eq(2));
+  }
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Fixed-capacity, lock-free ring buffer for exactly one producer thread and
+ * one consumer thread.
+ *
+ * Uses the `CircVector` layout (a power-of-two buffer addressed by a front
+ * index and a size), but the front and back are free-running atomic
+ * counters: `head` is advanced only by the consumer and `tail` only by the
+ * producer, so the size is `tail - head`. Each side keeps its counter and a
+ * cached copy of the other side's counter on its own cache line, and only
+ * re-reads the shared counter when the cached one says the ring is full
+ * (producer) or empty (consumer).
+ *
+ * Calling producer methods from more than one thread, or consumer methods
+ * from more than one thread, is undefined behaviour.
+ */
+template <typename T>
+class SpscRing {
+ private:
+  static constexpr size_t cache_line = 64;
+
+  // Read-only after construction, shared by both sides.
+  alignas(cache_line) T *data;
+  size_t capacity;
+  size_t mask;
+
+  // Consumer side.
+  alignas(cache_line) atomic<size_t> head;
+  size_t cached_tail;
+
+  // Producer side.
+  alignas(cache_line) atomic<size_t> tail;
+  size_t cached_head;
+
+  static constexpr size_t buffer_align = max(alignof(T), cache_line);
+
+  /**
+   * Returns how many slots the producer can fill without overwriting,
+   * refreshing its view of `head` if fewer than `wanted` appear free.
+   */
+  size_t free_slots(size_t t, size_t wanted) {
+    size_t free = capacity - (t - cached_head);
+    if (free < wanted) {
+      cached_head = head.load(memory_order_acquire);
+      free = capacity - (t - cached_head);
+    }
+    return free;
+  }
+
+  /**
+   * Returns how many elements the consumer can take, refreshing its view of
+   * `tail` if fewer than `wanted` appear available.
+   */
+  size_t available(size_t h, size_t wanted) {
+    size_t avail = cached_tail - h;
+    if (avail < wanted) {
+      cached_tail = tail.load(memory_order_acquire);
+      avail = cached_tail - h;
+    }
+    return avail;
+  }
+
+ public:
+  /**
+   * Creates an empty ring holding at least `capacity` elements (rounded up
+   * to a power of two). Throws `invalid_argument` if `capacity` is 0.
+   */
+  explicit SpscRing(size_t capacity) {
+    if (capacity == 0) {
+      throw invalid_argument("Capacity must be > 0");
+    }
+    this->capacity = bit_ceil(capacity);
+    mask = this->capacity - 1;
+    data = static_cast<T *>(::operator new(this->capacity * sizeof(T),
+                                           align_val_t(buffer_align)));
+    head.store(0, memory_order_relaxed);
+    tail.store(0, memory_order_relaxed);
+    cached_head = 0;
+    cached_tail = 0;
+  }
+
+  SpscRing(const SpscRing &other) = delete;
+  SpscRing &operator=(const SpscRing &other) = delete;
+
+  /**
+   * Destructor. Destroys any elements still queued. Neither side may be
+   * using the ring.
+   */
+  ~SpscRing() {
+    size_t t = tail.load(memory_order_relaxed);
+    for (size_t h = head.load(memory_order_relaxed); h != t; h++) {
+      destroy_at(data + (h & mask));
+    }
+    ::operator delete(data, align_val_t(buffer_align));
+  }
+
+  /**
+   * Producer: constructs an element from `args` at the back. Returns false,
+   * without constructing anything, if the ring is full.
+   */
+  template <typename... Args>
+  bool try_emplace(Args &&...args) {
+    size_t t = tail.load(memory_order_relaxed);
+    if (free_slots(t, 1) == 0) {
+      return false;
+    }
+    construct_at(data + (t & mask), std::forward<Args>(args)...);
+    tail.store(t + 1, memory_order_release);
+    return true;
+  }
+
+  /**
+   * Producer: copies `elem` onto the back. Returns false if the ring is full.
+   */
+  bool try_push(const T &elem) {
+    return try_emplace(elem);
+  }
+
+  /**
+   * Producer: moves `elem` onto the back. Returns false, leaving `elem`
+   * untouched, if the ring is full.
+   */
+  bool try_push(T &&elem) {
+    return try_emplace(std::move(elem));
+  }
+
+  /**
+   * Producer: copies as many of the `n` elements at `items` as fit, in
+   * order, publishing them all at once. Returns the number pushed.
+   */
+  size_t try_push_batch(const T *items, size_t n) {
+    size_t t = tail.load(memory_order_relaxed);
+    size_t count = min(n, free_slots(t, n));
+    for (size_t i = 0; i < count; i++) {
+      construct_at(data + ((t + i) & mask), items[i]);
+    }
+    if (count > 0) {
+      tail.store(t + count, memory_order_release);
+    }
+    return count;
+  }
+
+  /**
+   * Consumer: moves the front element into `out` and removes it. Returns
+   * false, leaving `out` untouched, if the ring is empty.
+   */
+  bool try_pop(T &out) {
+    size_t h = head.load(memory_order_relaxed);
+    if (available(h, 1) == 0) {
+      return false;
+    }
+    T *slot = data + (h & mask);
+    out = std::move(*slot);
+    destroy_at(slot);
+    head.store(h + 1, memory_order_release);
+    return true;
+  }
+
+  /**
+   * Consumer: moves up to `max_items` elements from the front into `out`,
+   * in order, releasing their slots all at once. Returns the number popped.
+   */
+  size_t try_pop_batch(T *out, size_t max_items) {
+    size_t h = head.load(memory_order_relaxed);
+    size_t count = min(max_items, available(h, max_items));
+    for (size_t i = 0; i < count; i++) {
+      T *slot = data + ((h + i) & mask);
+      out[i] = std::move(*slot);
+      destroy_at(slot);
+    }
+    if (count > 0) {
+      head.store(h + count, memory_order_release);
+    }
+    return count;
+  }
+
+  /**
+   * Returns the number of queued elements. Exact only when neither side is
+   * running concurrently; otherwise a snapshot that may already be stale.
+   */
+  size_t size() const {
+    size_t h = head.load(memory_order_acquire);
+    size_t t = tail.load(memory_order_acquire);
+    return t - h;
+  }
+
+  /**
+   * Returns whether the ring is empty, with the same caveat as `size()`.
+   */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * Returns the number of slots in the ring.
+   */
+  size_t get_capacity() const {
+    return capacity;
+  }
+};
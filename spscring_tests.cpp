@@ -0,0 +1,117 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spscring.h"
+
+using namespace std;
+using namespace testing;
+
+TEST(SpscRingCore, pushPopInOrder) {
+  SpscRing<int> ring(4);
+
+  EXPECT_THAT(ring.empty(), Eq(true));
+  EXPECT_THAT(ring.try_push(1), Eq(true));
+  EXPECT_THAT(ring.try_push(2), Eq(true));
+  EXPECT_THAT(ring.size(), Eq(2));
+
+  int out = 0;
+  EXPECT_THAT(ring.try_pop(out), Eq(true));
+  EXPECT_THAT(out, Eq(1));
+  EXPECT_THAT(ring.try_pop(out), Eq(true));
+  EXPECT_THAT(out, Eq(2));
+  EXPECT_THAT(ring.try_pop(out), Eq(false));
+  EXPECT_THAT(out, Eq(2));
+}
+TEST(SpscRingCore, fullAndWrap) {
+  SpscRing<int> ring(3);
+  EXPECT_THAT(ring.get_capacity(), Eq(4));
+  EXPECT_THROW(SpscRing<int>(0), invalid_argument);
+
+  int out = 0;
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 4; i++) {
+      EXPECT_THAT(ring.try_push(round * 10 + i), Eq(true));
+    }
+    EXPECT_THAT(ring.try_push(99), Eq(false));
+    for (int i = 0; i < 4; i++) {
+      ring.try_pop(out);
+      EXPECT_THAT(out, Eq(round * 10 + i));
+    }
+  }
+}
+TEST(SpscRingCore, moveOnlyAndLeftovers) {
+  SpscRing<unique_ptr<string>> ring(2);
+  EXPECT_THAT(ring.try_emplace(new string("a")), Eq(true));
+  EXPECT_THAT(ring.try_push(make_unique<string>("b")), Eq(true));
+
+  unique_ptr<string> rejected = make_unique<string>("c");
+  EXPECT_THAT(ring.try_push(std::move(rejected)), Eq(false));
+  EXPECT_THAT(*rejected, Eq("c"));
+
+  unique_ptr<string> out;
+  ring.try_pop(out);
+  EXPECT_THAT(*out, Eq("a"));
+  // "b" is destroyed with the ring.
+}
+TEST(SpscRingCore, batches) {
+  SpscRing<int> ring(8);
+  int items[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+  EXPECT_THAT(ring.try_push_batch(items, 6), Eq(6));
+  int out[10] = {};
+  EXPECT_THAT(ring.try_pop_batch(out, 4), Eq(4));
+  EXPECT_THAT(out[3], Eq(3));
+  EXPECT_THAT(ring.try_push_batch(items, 10), Eq(6));
+  EXPECT_THAT(ring.try_pop_batch(out, 10), Eq(8));
+  EXPECT_THAT(out[0], Eq(4));
+  EXPECT_THAT(out[2], Eq(0));
+  EXPECT_THAT(out[7], Eq(5));
+  EXPECT_THAT(ring.try_pop_batch(out, 10), Eq(0));
+}
+TEST(SpscRingThreads, streamPreservesOrder) {
+  const int count = 50000;
+  SpscRing<int> ring(64);
+
+  thread producer([&] {
+    int batch[16];
+    int next = 0;
+    while (next < count) {
+      if (next % 3 == 0) {
+        int n = min(16, count - next);
+        for (int i = 0; i < n; i++) {
+          batch[i] = next + i;
+        }
+        next += ring.try_push_batch(batch, n);
+      }
+      else if (ring.try_push(next)) {
+        next++;
+      }
+      else {
+        this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  bool ordered = true;
+  int out[32];
+  while (expected < count) {
+    size_t n = ring.try_pop_batch(out, 32);
+    if (n == 0) {
+      this_thread::yield();
+    }
+    for (size_t i = 0; i < n; i++) {
+      ordered = ordered && (out[i] == expected);
+      expected++;
+    }
+  }
+  producer.join();
+
+  EXPECT_THAT(ordered, Eq(true));
+  EXPECT_THAT(ring.empty(), Eq(true));
+}
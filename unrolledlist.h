@@ -0,0 +1,687 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Unrolled doubly-linked list: each node holds a small array of elements
+ * plus a fill count, sized so that a node spans `NodeBytes` (one or two cache
+ * lines). Traversals touch one node per `node_capacity` elements instead of
+ * one per element.
+ *
+ * Exposes the same API as `LinkedList`, so the two can be swapped with a type
+ * alias. Inserting into a full node splits it in half; removing from a node
+ * that drops below half full merges it with a neighbour when they fit in one
+ * node.
+ */
+template <typename T, size_t NodeBytes = 128>
+class UnrolledList {
+ private:
+  static constexpr size_t header_bytes = 3 * sizeof(void *);
+
+ public:
+  /**
+   * Number of elements stored per node.
+   */
+  static constexpr size_t node_capacity =
+      max<size_t>(2, (NodeBytes > header_bytes ? NodeBytes - header_bytes : 0) /
+                         sizeof(T));
+
+ private:
+  class Node {
+   public:
+    Node *next = nullptr;
+    Node *prev = nullptr;
+    size_t count = 0;
+    alignas(T) unsigned char storage[node_capacity * sizeof(T)];
+
+    T *slot(size_t i) {
+      return reinterpret_cast<T *>(storage) + i;
+    }
+
+    bool full() const {
+      return count == node_capacity;
+    }
+  };
+
+  size_t list_size;
+  Node *list_front;
+  Node *list_back;
+
+  /**
+   * Allocates an empty node and links it in after `prev`, or at the front if
+   * `prev` is null.
+   */
+  Node *new_node_after(Node *prev) {
+    Node *node = new Node;
+    node->prev = prev;
+    node->next = (prev == nullptr) ? list_front : prev->next;
+    if (node->next != nullptr) {
+      node->next->prev = node;
+    }
+    else {
+      list_back = node;
+    }
+    if (prev != nullptr) {
+      prev->next = node;
+    }
+    else {
+      list_front = node;
+    }
+    return node;
+  }
+
+  /**
+   * Unlinks and frees a node. Its elements must already be destroyed or
+   * moved out.
+   */
+  void delete_node(Node *node) {
+    if (node->prev != nullptr) {
+      node->prev->next = node->next;
+    }
+    else {
+      list_front = node->next;
+    }
+    if (node->next != nullptr) {
+      node->next->prev = node->prev;
+    }
+    else {
+      list_back = node->prev;
+    }
+    delete node;
+  }
+
+  /**
+   * Finds the node holding the element at `index` (which must be valid),
+   * walking from whichever end is closer. Returns the node and sets `offset`
+   * to the element's position within it.
+   */
+  Node *locate(size_t index, size_t &offset) const {
+    if (index < list_size / 2) {
+      Node *node = list_front;
+      while (index >= node->count) {
+        index -= node->count;
+        node = node->next;
+      }
+      offset = index;
+      return node;
+    }
+    size_t remaining = list_size - index;
+    Node *node = list_back;
+    while (remaining > node->count) {
+      remaining -= node->count;
+      node = node->prev;
+    }
+    offset = node->count - remaining;
+    return node;
+  }
+
+  /**
+   * Constructs an element at `offset` within a node that is not full,
+   * shifting later elements in that node up by one.
+   */
+  template <typename... Args>
+  T &insert_in_node(Node *node, size_t offset, Args &&...args) {
+    if (offset == node->count) {
+      construct_at(node->slot(offset), std::forward<Args>(args)...);
+    }
+    else {
+      T elem(std::forward<Args>(args)...);
+      construct_at(node->slot(node->count),
+                   std::move(*node->slot(node->count - 1)));
+      for (size_t i = node->count - 1; i > offset; i--) {
+        *node->slot(i) = std::move(*node->slot(i - 1));
+      }
+      *node->slot(offset) = std::move(elem);
+    }
+    node->count++;
+    list_size++;
+    return *node->slot(offset);
+  }
+
+  /**
+   * Removes the element at `offset` within a node, shifting later elements
+   * in that node down by one. Frees the node if it becomes empty.
+   */
+  void erase_in_node(Node *node, size_t offset) {
+    for (size_t i = offset; i + 1 < node->count; i++) {
+      *node->slot(i) = std::move(*node->slot(i + 1));
+    }
+    destroy_at(node->slot(node->count - 1));
+    node->count--;
+    list_size--;
+    if (node->count == 0) {
+      delete_node(node);
+    }
+  }
+
+  /**
+   * Moves every element of `src` onto the end of `dst`, then frees `src`.
+   * The two must fit in one node.
+   */
+  void merge_into(Node *dst, Node *src) {
+    for (size_t i = 0; i < src->count; i++) {
+      construct_at(dst->slot(dst->count + i), std::move(*src->slot(i)));
+      destroy_at(src->slot(i));
+    }
+    dst->count += src->count;
+    src->count = 0;
+    delete_node(src);
+  }
+
+  /**
+   * Merges a node that has dropped below half full with a neighbour, if the
+   * two fit in one node.
+   */
+  void rebalance(Node *node) {
+    if (node->count >= node_capacity / 2) {
+      return;
+    }
+    if (node->next != nullptr &&
+        node->count + node->next->count <= node_capacity) {
+      merge_into(node, node->next);
+    }
+    else if (node->prev != nullptr &&
+             node->prev->count + node->count <= node_capacity) {
+      merge_into(node->prev, node);
+    }
+  }
+
+  /**
+   * Moves the upper half of a full node into a new node linked after it, and
+   * returns the new node.
+   */
+  Node *split(Node *node) {
+    Node *upper = new_node_after(node);
+    size_t half = node->count / 2;
+    for (size_t i = half; i < node->count; i++) {
+      construct_at(upper->slot(i - half), std::move(*node->slot(i)));
+      destroy_at(node->slot(i));
+    }
+    upper->count = node->count - half;
+    node->count = half;
+    return upper;
+  }
+
+  /**
+   * Constructs a new element at position `index` (`0 <= index <= size`) and
+   * returns a reference to it.
+   */
+  template <typename... Args>
+  T &emplace_at(size_t index, Args &&...args) {
+    if (index == list_size) {
+      Node *node = list_back;
+      if (node == nullptr || node->full()) {
+        node = new_node_after(list_back);
+      }
+      return insert_in_node(node, node->count, std::forward<Args>(args)...);
+    }
+
+    size_t offset = 0;
+    Node *node = locate(index, offset);
+    if (!node->full()) {
+      return insert_in_node(node, offset, std::forward<Args>(args)...);
+    }
+
+    // Build the element before moving anything, in case `args` refers to an
+    // element of this list.
+    T elem(std::forward<Args>(args)...);
+    if (offset == 0) {
+      Node *prev = node->prev;
+      if (prev == nullptr || prev->full()) {
+        prev = new_node_after(prev);
+      }
+      return insert_in_node(prev, prev->count, std::move(elem));
+    }
+    Node *upper = split(node);
+    if (offset <= node->count) {
+      return insert_in_node(node, offset, std::move(elem));
+    }
+    return insert_in_node(upper, offset - node->count, std::move(elem));
+  }
+
+  /**
+   * Appends copies of every element of `other`. Runs in O(N) time.
+   */
+  void copy_from(const UnrolledList &other) {
+    for (Node *node = other.list_front; node != nullptr; node = node->next) {
+      for (size_t i = 0; i < node->count; i++) {
+        emplace_at(list_size, *node->slot(i));
+      }
+    }
+  }
+
+  /**
+   * Takes over the nodes of `other`, leaving it empty. This list must be
+   * empty.
+   */
+  void steal_from(UnrolledList &other) {
+    list_size = other.list_size;
+    list_front = other.list_front;
+    list_back = other.list_back;
+    other.list_size = 0;
+    other.list_front = nullptr;
+    other.list_back = nullptr;
+  }
+
+ public:
+  /**
+   * Forward iterator over the elements, walking each node's array before
+   * following its `next` pointer.
+   */
+  template <bool IsConst>
+  class Iterator {
+   private:
+    Node *node = nullptr;
+    size_t offset = 0;
+
+    friend class UnrolledList;
+    friend class Iterator<!IsConst>;
+
+    Iterator(Node *node, size_t offset) : node(node), offset(offset) {
+    }
+
+   public:
+    using iterator_category = forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = conditional_t<IsConst, const T *, T *>;
+    using reference = conditional_t<IsConst, const T &, T &>;
+
+    Iterator() = default;
+
+    /**
+     * Converts an `iterator` to a `const_iterator`.
+     */
+    template <bool OtherConst>
+      requires(IsConst && !OtherConst)
+    Iterator(const Iterator<OtherConst> &other)
+        : node(other.node), offset(other.offset) {
+    }
+
+    reference operator*() const {
+      return *node->slot(offset);
+    }
+
+    pointer operator->() const {
+      return node->slot(offset);
+    }
+
+    Iterator &operator++() {
+      if (++offset == node->count) {
+        node = node->next;
+        offset = 0;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.node == b.node && a.offset == b.offset;
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  /**
+   * Default constructor. Creates an empty `UnrolledList`.
+   */
+  UnrolledList() {
+    list_size = 0;
+    list_front = nullptr;
+    list_back = nullptr;
+  }
+
+  /**
+   * Returns whether the `UnrolledList` is empty (i.e. whether its
+   * size is 0).
+   */
+  bool empty() const {
+    return list_size == 0;
+  }
+
+  /**
+   * Returns the number of elements in the `UnrolledList`.
+   */
+  size_t size() const {
+    return list_size;
+  }
+
+  /**
+   * Adds the given `T` to the front of the `UnrolledList`.
+   */
+  void push_front(const T &data) {
+    emplace_at(0, data);
+  }
+
+  /**
+   * Moves the given `T` onto the front of the `UnrolledList`.
+   */
+  void push_front(T &&data) {
+    emplace_at(0, std::move(data));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments at the front of the
+   * `UnrolledList`, and returns a reference to it.
+   */
+  template <typename... Args>
+  T &emplace_front(Args &&...args) {
+    return emplace_at(0, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Adds the given `T` to the back of the `UnrolledList`.
+   */
+  void push_back(const T &data) {
+    emplace_at(list_size, data);
+  }
+
+  /**
+   * Moves the given `T` onto the back of the `UnrolledList`.
+   */
+  void push_back(T &&data) {
+    emplace_at(list_size, std::move(data));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments at the back of the
+   * `UnrolledList`, and returns a reference to it.
+   */
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    return emplace_at(list_size, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Removes the element at the front of the `UnrolledList`.
+   *
+   * If the `UnrolledList` is empty, throws a `runtime_error`.
+   */
+  T pop_front() {
+    if (list_size == 0) {
+      throw runtime_error("List is empty.");
+    }
+    T value = std::move(*list_front->slot(0));
+    erase_in_node(list_front, 0);
+    return value;
+  }
+
+  /**
+   * Removes the element at the back of the `UnrolledList`.
+   *
+   * If the `UnrolledList` is empty, throws a `runtime_error`.
+   */
+  T pop_back() {
+    if (list_size == 0) {
+      throw runtime_error("List is empty.");
+    }
+    T value = std::move(*list_back->slot(list_back->count - 1));
+    erase_in_node(list_back, list_back->count - 1);
+    return value;
+  }
+
+  /**
+   * Empties the `UnrolledList`, releasing all allocated memory.
+   */
+  void clear() {
+    Node *node = list_front;
+    while (node != nullptr) {
+      Node *next = node->next;
+      for (size_t i = 0; i < node->count; i++) {
+        destroy_at(node->slot(i));
+      }
+      delete node;
+      node = next;
+    }
+    list_front = nullptr;
+    list_back = nullptr;
+    list_size = 0;
+  }
+
+  /**
+   * Destructor. Clears all allocated memory.
+   */
+  ~UnrolledList() {
+    clear();
+  }
+
+  /**
+   * Returns the element at the given index in the `UnrolledList`.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  T &at(size_t index) const {
+    if (index >= list_size) {
+      throw out_of_range("Index is invalid.");
+    }
+    size_t offset = 0;
+    Node *node = locate(index, offset);
+    return *node->slot(offset);
+  }
+
+  /**
+   * Copy constructor. Creates a deep copy of the given `UnrolledList`, with
+   * every node packed full.
+   */
+  UnrolledList(const UnrolledList &other) : UnrolledList() {
+    copy_from(other);
+  }
+
+  /**
+   * Move constructor. Takes over the nodes of the given `UnrolledList`, which
+   * is left empty.
+   */
+  UnrolledList(UnrolledList &&other) noexcept : UnrolledList() {
+    steal_from(other);
+  }
+
+  /**
+   * Assignment operator. Sets the current `UnrolledList` to a deep copy of
+   * the given `UnrolledList`.
+   */
+  UnrolledList &operator=(const UnrolledList &other) {
+    if (this == &other) {
+      return *this;
+    }
+    clear();
+    copy_from(other);
+    return *this;
+  }
+
+  /**
+   * Move assignment operator. Frees the current nodes and takes over the
+   * nodes of the given `UnrolledList`, which is left empty.
+   */
+  UnrolledList &operator=(UnrolledList &&other) noexcept {
+    if (this == &other) {
+      return *this;
+    }
+    clear();
+    steal_from(other);
+    return *this;
+  }
+
+  /**
+   * Converts the `UnrolledList` to a string. Formatted like
+   * `[0, 1, 2, 3, 4]`.
+   */
+  string to_string() const {
+    stringstream ss;
+    ss << "[";
+    for (const_iterator it = begin(); it != end(); ++it) {
+      if (it != begin()) {
+        ss << ", ";
+      }
+      ss << *it;
+    }
+    ss << "]";
+    return ss.str();
+  }
+
+  /**
+   * Searches the `UnrolledList` for the first matching element, and returns
+   * its index. If no match is found, returns "-1".
+   */
+  size_t find(const T &data) {
+    size_t index = 0;
+    for (Node *node = list_front; node != nullptr; node = node->next) {
+      for (size_t i = 0; i < node->count; i++) {
+        if (*node->slot(i) == data) {
+          return index + i;
+        }
+      }
+      index += node->count;
+    }
+    return -1;
+  }
+
+  /**
+   * Remove the element at the specified index in this list.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  void remove_at(size_t index) {
+    if (index >= list_size) {
+      throw out_of_range("Index not in the range");
+    }
+    size_t offset = 0;
+    Node *node = locate(index, offset);
+    bool emptied = (node->count == 1);
+    erase_in_node(node, offset);
+    if (!emptied) {
+      rebalance(node);
+    }
+  }
+
+  /**
+   * Inserts the given `T` as a new element in the `UnrolledList` after
+   * the given index. If the index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, const T &data) {
+    emplace_after(index, data);
+  }
+
+  /**
+   * Moves the given `T` into the `UnrolledList` after the given index. If
+   * the index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, T &&data) {
+    emplace_after(index, std::move(data));
+  }
+
+  /**
+   * Constructs a `T` from the given arguments as a new element after the
+   * given index, and returns a reference to it. If the index is invalid,
+   * throws `out_of_range`.
+   */
+  template <typename... Args>
+  T &emplace_after(size_t index, Args &&...args) {
+    if (index >= list_size) {
+      throw out_of_range("Index not in the range");
+    }
+    return emplace_at(index + 1, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Remove every element that is currently in an even-numbered position on
+   * the list. Compacts each node in place, then merges neighbouring nodes
+   * that fit together. Runs in O(N).
+   */
+  void remove_evens() {
+    size_t index = 0;
+    Node *node = list_front;
+    while (node != nullptr) {
+      Node *next = node->next;
+      size_t kept = 0;
+      for (size_t i = 0; i < node->count; i++, index++) {
+        if (index % 2 != 0) {
+          if (kept != i) {
+            *node->slot(kept) = std::move(*node->slot(i));
+          }
+          kept++;
+        }
+      }
+      for (size_t i = kept; i < node->count; i++) {
+        destroy_at(node->slot(i));
+      }
+      list_size -= node->count - kept;
+      node->count = kept;
+      if (kept == 0) {
+        delete_node(node);
+      }
+      node = next;
+    }
+
+    for (node = list_front; node != nullptr; node = node->next) {
+      while (node->next != nullptr &&
+             node->count + node->next->count <= node_capacity) {
+        merge_into(node, node->next);
+      }
+    }
+  }
+
+  /**
+   * Returns an iterator to the first element.
+   */
+  iterator begin() {
+    return iterator(list_front, 0);
+  }
+
+  /**
+   * Returns an iterator one past the last element.
+   */
+  iterator end() {
+    return iterator(nullptr, 0);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(list_front, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(nullptr, 0);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  /**
+   * Returns the number of nodes currently allocated. Runs in O(nodes) time.
+   */
+  size_t node_count() const {
+    size_t nodes = 0;
+    for (Node *node = list_front; node != nullptr; node = node->next) {
+      nodes++;
+    }
+    return nodes;
+  }
+
+  /**
+   * Returns a pointer to the node at the front of the `UnrolledList`.
+   */
+  void *front() const {
+    return this->list_front;
+  }
+};
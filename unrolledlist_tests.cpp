@@ -0,0 +1,162 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "unrolledlist.h"
+
+using namespace std;
+using namespace testing;
+
+// Small nodes (6 ints each) so that splits and merges happen quickly.
+using SmallList = UnrolledList<int, 48>;
+
+// Core
+TEST(UnrolledListCore, emptyList) {
+  UnrolledList<int> ll;
+  EXPECT_THAT(ll.empty(), Eq(true));
+  EXPECT_THAT(ll.size(), Eq(0));
+  EXPECT_THROW(ll.at(0), out_of_range);
+  EXPECT_THROW(ll.pop_back(), runtime_error);
+  EXPECT_THROW(ll.pop_front(), runtime_error);
+  EXPECT_THAT(ll.to_string(), Eq("[]"));
+}
+TEST(UnrolledListCore, nodeCapacity) {
+  EXPECT_THAT(SmallList::node_capacity, Eq(6));
+  EXPECT_THAT(UnrolledList<int>::node_capacity, Eq(26));
+  EXPECT_THAT(sizeof(UnrolledList<int>::iterator), Eq(16));
+}
+TEST(UnrolledListCore, pushPopBothEnds) {
+  SmallList ll;
+  for (int i = 0; i < 20; i++) {
+    ll.push_back(i);
+    ll.push_front(-i - 1);
+  }
+  EXPECT_THAT(ll.size(), Eq(40));
+  for (int i = 0; i < 40; i++) {
+    EXPECT_THAT(ll.at(i), Eq(i - 20));
+  }
+  for (int i = 19; i >= 0; i--) {
+    EXPECT_THAT(ll.pop_back(), Eq(i));
+    EXPECT_THAT(ll.pop_front(), Eq(-i - 1));
+  }
+  EXPECT_THAT(ll.empty(), Eq(true));
+  EXPECT_THAT(ll.node_count(), Eq(0));
+}
+TEST(UnrolledListCore, appendPacksNodes) {
+  SmallList ll;
+  for (int i = 0; i < 60; i++) {
+    ll.push_back(i);
+  }
+  EXPECT_THAT(ll.node_count(), Eq(10));
+}
+TEST(UnrolledListCore, clearList) {
+  UnrolledList<string> ll;
+  ll.push_back("a");
+  ll.emplace_back(3, 'b');
+  ll.clear();
+  EXPECT_THAT(ll.empty(), Eq(true));
+  ll.push_front("c");
+  EXPECT_THAT(ll.to_string(), Eq("[c]"));
+}
+
+// Augmented
+TEST(UnrolledListAugmented, copyAndAssign) {
+  SmallList l1;
+  for (int i = 0; i < 15; i++) {
+    l1.push_back(i);
+  }
+  SmallList l2(l1);
+  SmallList l3;
+  l3.push_back(99);
+  l3 = l1;
+  l1.clear();
+
+  EXPECT_THAT(l2.size(), Eq(15));
+  EXPECT_THAT(l3.at(14), Eq(14));
+  EXPECT_THAT(l2.to_string(), Eq(l3.to_string()));
+
+  SmallList l4(std::move(l2));
+  EXPECT_THAT(l2.empty(), Eq(true));
+  EXPECT_THAT(l4.size(), Eq(15));
+  l2 = std::move(l4);
+  EXPECT_THAT(l2.at(7), Eq(7));
+}
+TEST(UnrolledListAugmented, findAndIterate) {
+  SmallList ll;
+  for (int i = 0; i < 20; i++) {
+    ll.push_back(i * 2);
+  }
+  EXPECT_THAT(ll.find(0), Eq(0));
+  EXPECT_THAT(ll.find(26), Eq(13));
+  EXPECT_THAT(ll.find(27), Eq(-1));
+
+  vector<int> seen(ll.begin(), ll.end());
+  EXPECT_THAT(seen.size(), Eq(20));
+  EXPECT_THAT(seen[19], Eq(38));
+}
+
+// Extras
+TEST(UnrolledListExtras, insertSplitsNodes) {
+  SmallList ll;
+  vector<int> expected;
+  for (int i = 0; i < 6; i++) {
+    ll.push_back(i);
+    expected.push_back(i);
+  }
+  EXPECT_THAT(ll.node_count(), Eq(1));
+
+  ll.insert_after(2, 100);
+  expected.insert(expected.begin() + 3, 100);
+  EXPECT_THAT(ll.node_count(), Eq(2));
+
+  for (int i = 0; i < 30; i++) {
+    size_t index = (i * 7) % ll.size();
+    ll.insert_after(index, i);
+    expected.insert(expected.begin() + index + 1, i);
+  }
+  EXPECT_THAT(vector<int>(ll.begin(), ll.end()), Eq(expected));
+  EXPECT_THROW(ll.insert_after(ll.size(), 1), out_of_range);
+}
+TEST(UnrolledListExtras, removeMergesNodes) {
+  SmallList ll;
+  vector<int> expected;
+  for (int i = 0; i < 60; i++) {
+    ll.push_back(i);
+    expected.push_back(i);
+  }
+  while (ll.size() > 5) {
+    size_t index = (ll.size() * 5) % ll.size() + ll.size() / 3;
+    ll.remove_at(index);
+    expected.erase(expected.begin() + index);
+  }
+  EXPECT_THAT(vector<int>(ll.begin(), ll.end()), Eq(expected));
+  EXPECT_THAT(ll.node_count(), Le(2));
+  EXPECT_THROW(ll.remove_at(5), out_of_range);
+}
+TEST(UnrolledListExtras, removeEvens) {
+  SmallList ll;
+  for (int i = 0; i < 25; i++) {
+    ll.push_back(i);
+  }
+  ll.remove_evens();
+  EXPECT_THAT(ll.size(), Eq(12));
+  EXPECT_THAT(ll.at(0), Eq(1));
+  EXPECT_THAT(ll.at(11), Eq(23));
+  EXPECT_THAT(ll.node_count(), Eq(2));
+
+  SmallList empty;
+  empty.remove_evens();
+  EXPECT_THAT(empty.empty(), Eq(true));
+}
+TEST(UnrolledListExtras, insertOwnElement) {
+  UnrolledList<string, 64> ll;
+  for (int i = 0; i < UnrolledList<string, 64>::node_capacity; i++) {
+    ll.push_back(string(1, 'a' + i));
+  }
+  ll.insert_after(0, ll.at(1));
+  ll.push_front(ll.at(0));
+  EXPECT_THAT(ll.at(0), Eq("a"));
+  EXPECT_THAT(ll.at(2), Eq("b"));
+}